@@ -0,0 +1,79 @@
+// Measures the throughput of the keyed token buckets behind throttle and throttle_key under contention
+// Every thread looks up a key drawn from a shared key space and reserves a token in its bucket, as throttle_key does
+// for every key of a chunk, once spread over many keys and once all on one hot key, where the reservations of all
+// threads race on the same bucket
+
+#include "duckdb.hpp"
+#include "sleep_extension.hpp"
+#include "sleep_state.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace duckdb;
+
+static constexpr idx_t RESERVATIONS_PER_THREAD = 2000000;
+
+static double MeasureReservations(DuckDB &db, idx_t thread_count, const vector<string> &keys) {
+	vector<unique_ptr<Connection>> connections;
+	for (idx_t i = 0; i < thread_count; i++) {
+		connections.push_back(make_uniq<Connection>(db));
+	}
+	auto &bucket_map = SleepDatabaseState::Get(*db.instance).throttle_buckets;
+	std::atomic<idx_t> ready {0};
+	std::atomic<bool> go {false};
+	vector<std::thread> threads;
+	for (idx_t t = 0; t < thread_count; t++) {
+		threads.emplace_back([&, t]() {
+			auto &context = *connections[t]->context;
+			ready++;
+			while (!go) {
+			}
+			// Each thread walks the key space from its own offset with a stride, touching every shard
+			// The clock is read once per chunk of reservations, like throttle_key reads it once per chunk
+			idx_t key_idx = t * 7919;
+			int64_t now_ns = 0;
+			for (idx_t i = 0; i < RESERVATIONS_PER_THREAD; i++) {
+				if (i % STANDARD_VECTOR_SIZE == 0) {
+					now_ns = SleepClockNow(context, SleepClock::MONOTONIC);
+				}
+				auto &key = keys[key_idx % keys.size()];
+				string_t key_ref(key.c_str(), UnsafeNumericCast<uint32_t>(key.size()));
+				auto bucket = bucket_map.Get(context, key_ref, SleepClock::MONOTONIC, 1e9, 0, 1);
+				bucket->Reserve(now_ns, 1);
+				key_idx += 104729;
+			}
+		});
+	}
+	while (ready < thread_count) {
+	}
+	auto start = std::chrono::steady_clock::now();
+	go = true;
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(thread_count * RESERVATIONS_PER_THREAD) / seconds;
+}
+
+int main() {
+	DuckDB db(nullptr);
+	db.LoadStaticExtension<SleepExtension>();
+
+	vector<string> tenant_keys;
+	for (idx_t i = 0; i < 100000; i++) {
+		tenant_keys.push_back("tenant-" + std::to_string(i));
+	}
+	vector<string> hot_key {"tenant-hot"};
+
+	auto max_threads = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+	printf("%8s %20s %20s\n", "threads", "100k keys (M/s)", "one key (M/s)");
+	for (idx_t threads = 1; threads <= max_threads; threads *= 2) {
+		auto spread = MeasureReservations(db, threads, tenant_keys);
+		auto hot = MeasureReservations(db, threads, hot_key);
+		printf("%8llu %20.2f %20.2f\n", static_cast<unsigned long long>(threads), spread / 1e6, hot / 1e6);
+	}
+	return 0;
+}
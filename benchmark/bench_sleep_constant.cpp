@@ -0,0 +1,47 @@
+// Measures the per-row cost of sleep functions whose argument is a constant that needs no wait, e.g. sleep(0) over a
+// billion rows, next to the same scan without a sleep
+// The constant-vector path validates and converts the duration once per chunk, so the difference to the plain scan
+// should be close to zero
+
+#include "duckdb.hpp"
+#include "sleep_extension.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace duckdb;
+
+static constexpr idx_t DEFAULT_ROWS = 1000000000;
+
+static double MeasureSeconds(Connection &con, const string &query) {
+	auto start = std::chrono::steady_clock::now();
+	auto result = con.Query(query);
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (result->HasError()) {
+		fprintf(stderr, "%s: %s\n", query.c_str(), result->GetError().c_str());
+		exit(1);
+	}
+	return seconds;
+}
+
+int main(int argc, char **argv) {
+	auto rows = argc > 1 ? static_cast<idx_t>(strtoull(argv[1], nullptr, 10)) : DEFAULT_ROWS;
+	DuckDB db(nullptr);
+	db.LoadStaticExtension<SleepExtension>();
+	Connection con(db);
+
+	auto range = "range(" + std::to_string(rows) + ") t(i)";
+	auto baseline = MeasureSeconds(con, "SELECT count(i) FROM " + range);
+	const char *arguments[] = {"sleep(0)", "sleep(-1)", "sleep(NULL::DOUBLE)", "sleep_for(INTERVAL 0 SECOND)",
+	                           "sleep_until(TIMESTAMP '2000-01-01')"};
+	printf("%-40s %14s %14s\n", "query", "rows/s (M)", "ns/row extra");
+	printf("%-40s %14.1f %14s\n", "count(i) without a sleep", static_cast<double>(rows) / baseline / 1e6, "-");
+	for (auto argument : arguments) {
+		auto seconds = MeasureSeconds(con, "SELECT count(s) FROM (SELECT " + string(argument) + " AS s FROM " + range +
+		                                       ")");
+		printf("%-40s %14.1f %14.3f\n", argument, static_cast<double>(rows) / seconds / 1e6,
+		       (seconds - baseline) * 1e9 / static_cast<double>(rows));
+	}
+	return 0;
+}
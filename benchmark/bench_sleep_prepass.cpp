@@ -0,0 +1,51 @@
+// Measures the per-row cost of the pre-pass over non-constant durations: columns that are zero, negative or in the
+// past for almost every row, as in sleep(x) parameterized by a column, next to the same scan without a sleep
+// Rows that need no wait are skipped in bulk without clock reads, so the difference to the plain scan should stay a
+// small constant per row; one row in a million sleeps for a microsecond
+
+#include "duckdb.hpp"
+#include "sleep_extension.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace duckdb;
+
+static constexpr idx_t DEFAULT_ROWS = 1000000000;
+
+static double MeasureSeconds(Connection &con, const string &query) {
+	auto start = std::chrono::steady_clock::now();
+	auto result = con.Query(query);
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (result->HasError()) {
+		fprintf(stderr, "%s: %s\n", query.c_str(), result->GetError().c_str());
+		exit(1);
+	}
+	return seconds;
+}
+
+int main(int argc, char **argv) {
+	auto rows = argc > 1 ? static_cast<idx_t>(strtoull(argv[1], nullptr, 10)) : DEFAULT_ROWS;
+	DuckDB db(nullptr);
+	db.LoadStaticExtension<SleepExtension>();
+	Connection con(db);
+
+	auto range = "range(" + std::to_string(rows) + ") t(i)";
+	// The plain scan computes a value per row as well, so only the sleep is measured on top of it
+	auto baseline = MeasureSeconds(con, "SELECT count(s) FROM (SELECT (i % 2) * 0.0 AS s FROM " + range + ")");
+	const char *arguments[] = {"sleep((i % 2) * 0.0)",
+	                           "sleep(CASE WHEN i % 1000000 = 0 THEN 0.000001 ELSE 0 END)",
+	                           "sleep(-(i % 7) * 1.0)",
+	                           "sleep_for(to_microseconds(-(i % 2)))",
+	                           "sleep_until(TIMESTAMP '2000-01-01' + to_microseconds(i % 1000))"};
+	printf("%-60s %14s %14s\n", "query", "rows/s (M)", "ns/row extra");
+	printf("%-60s %14.1f %14s\n", "(i % 2) * 0.0 without a sleep", static_cast<double>(rows) / baseline / 1e6, "-");
+	for (auto argument : arguments) {
+		auto seconds = MeasureSeconds(con, "SELECT count(s) FROM (SELECT " + string(argument) + " AS s FROM " + range +
+		                                       ")");
+		printf("%-60s %14.1f %14.3f\n", argument, static_cast<double>(rows) / seconds / 1e6,
+		       (seconds - baseline) * 1e9 / static_cast<double>(rows));
+	}
+	return 0;
+}
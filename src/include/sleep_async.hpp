@@ -0,0 +1,40 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/parallel/interrupt.hpp"
+#include "sleep_timer_service.hpp"
+
+namespace duckdb {
+
+class ExtensionLoader;
+
+// A timer that reschedules a blocked pipeline task when it fires
+// Sources return SourceResultType::BLOCKED after arming it, so the worker thread goes back to the pool while waiting
+class AsyncSleepTimer : public SleepTimer {
+public:
+	explicit AsyncSleepTimer(ClientContext &context) : SleepTimer(context) {
+	}
+	~AsyncSleepTimer() override {
+		SleepTimerService::Get().Cancel(*this);
+	}
+
+	void Arm(const InterruptState &state, SleepTimerService::time_point_t deadline) {
+		auto &service = SleepTimerService::Get();
+		service.Cancel(*this);
+		interrupt_state = state;
+		service.Arm(*this, deadline);
+	}
+
+	void Fire(SleepTimerFireReason reason, vector<InterruptState> &reschedule) override {
+		// On interruption the task is rescheduled as well, it then observes the interrupt and throws
+		// The state only holds weak references to the task, so the copy stays valid after this timer is destroyed
+		reschedule.push_back(interrupt_state);
+	}
+
+private:
+	InterruptState interrupt_state;
+};
+
+void RegisterAsyncSleepFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
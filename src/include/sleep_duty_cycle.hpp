@@ -0,0 +1,19 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+class ExtensionLoader;
+
+struct SleepDutyCycleStatistics {
+	//! CPU time the pipelines of throttled queries used, and the time they slept to stay under cpu_duty_cycle
+	uint64_t busy_total_us = 0;
+	uint64_t throttled_total_us = 0;
+};
+
+SleepDutyCycleStatistics GetSleepDutyCycleStatistics();
+
+void RegisterDutyCycleFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
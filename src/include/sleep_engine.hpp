@@ -0,0 +1,167 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/interval.hpp"
+
+namespace duckdb {
+
+// Maximum sleep duration in seconds (1 hour) to prevent accidental infinite waits
+static constexpr double MAX_SLEEP_SECONDS = 3600.0;
+static constexpr int64_t MAX_SLEEP_MICROS = 3600 * Interval::MICROS_PER_SEC;
+
+static constexpr int64_t NANOS_PER_MICRO = 1000;
+static constexpr int64_t NANOS_PER_SECOND = 1000000000;
+
+// Deadlines on clocks other than the monotonic one are re-evaluated at least this often (1 second),
+// so wall-clock jumps and suspend are noticed while a sleep is parked
+static constexpr int64_t CLOCK_RECHECK_NS = NANOS_PER_SECOND;
+
+// How a chunk of sleep durations is turned into waits (the sleep_vector_mode setting)
+enum class SleepVectorMode : uint8_t {
+	//! Every row sleeps for its own duration, one after another
+	SERIAL,
+	//! The chunk sleeps once, for its longest duration
+	MAX,
+	//! The chunk sleeps once, for the sum of its durations
+	SUM,
+	//! The chunk sleeps once, for the duration of its first non-NULL row
+	PER_CHUNK
+};
+
+SleepVectorMode ParseSleepVectorMode(const string &mode);
+SleepVectorMode GetSleepVectorMode(ClientContext &context);
+
+// How closely a sleep tracks its deadline (the sleep_precision setting)
+enum class SleepPrecision : uint8_t {
+	//! Block until the deadline; the OS may overshoot by its timer slack
+	STANDARD,
+	//! Block until a calibrated margin before the deadline, then spin on the monotonic clock
+	PRECISE
+};
+
+// Clock that relative sleeps measure their deadline on (the sleep_clock setting)
+// sleep_until targets are wall-clock timestamps and use REALTIME, or VIRTUAL when that clock is selected
+enum class SleepClock : uint8_t {
+	//! Steady clock that is not affected by wall-clock changes and stops during suspend
+	MONOTONIC,
+	//! Wall clock; follows NTP adjustments and settime
+	REALTIME,
+	//! Like MONOTONIC, but keeps running while the system is suspended
+	BOOTTIME,
+	//! Simulated per-database wall clock; sleeps advance it instantly instead of blocking
+	VIRTUAL
+};
+
+SleepClock ParseSleepClock(const string &clock);
+SleepClock GetSleepClock(ClientContext &context);
+// Clock that sleep_until targets and sleep_now() are resolved against: REALTIME or VIRTUAL
+SleepClock GetSleepUntilClock(ClientContext &context);
+
+// Reads the clock in nanoseconds
+int64_t SleepClockNow(ClientContext &context, SleepClock clock);
+int64_t SleepClockNow(DatabaseInstance &db, SleepClock clock);
+// Current time of the clock that sleep_until targets are resolved against (sleep_now)
+timestamp_t SleepTimestampNow(ClientContext &context);
+
+// Converts a sleep_until target to a deadline in nanoseconds on the clock whose current time is now_ns,
+// capped at MAX_SLEEP_SECONDS from now
+int64_t TimestampToDeadline(timestamp_t target, int64_t now_ns);
+
+SleepPrecision ParseSleepPrecision(const string &precision);
+SleepPrecision GetSleepPrecision(ClientContext &context);
+
+// Factor that sleep durations are multiplied with (the sleep_time_scale setting), 0.01 runs a workload 100x faster
+// Throws if the factor is negative or not finite
+double ValidateSleepTimeScale(double scale);
+double GetSleepTimeScale(ClientContext &context);
+// Applies the time scale to a clamped duration, rounding to the nearest microsecond
+int64_t ScaleSleepMicros(int64_t micros, double scale);
+
+struct SleepEngineStatistics {
+	uint64_t sleeps = 0;
+	uint64_t precise_sleeps = 0;
+	//! Time slept past the deadline, in nanoseconds
+	uint64_t overshoot_total_ns = 0;
+	uint64_t overshoot_max_ns = 0;
+	uint64_t precise_overshoot_total_ns = 0;
+	uint64_t precise_overshoot_max_ns = 0;
+	//! Time spent spinning in precise sleeps, in nanoseconds
+	uint64_t spin_total_ns = 0;
+	//! Total duration requested by relative sleeps, in microseconds
+	uint64_t requested_total_us = 0;
+	//! Total duration of relative sleeps after applying sleep_time_scale, in microseconds
+	uint64_t scaled_total_us = 0;
+	//! Current calibrated margin before the deadline at which precise sleeps start spinning
+	uint64_t precise_margin_ns = 0;
+	//! Sleeps that advanced the virtual clock instead of blocking, and by how much in total
+	uint64_t virtual_sleeps = 0;
+	uint64_t virtual_advanced_us = 0;
+};
+
+SleepEngineStatistics GetSleepEngineStatistics();
+
+// Check for query cancellation (similar to PostgreSQL's CHECK_FOR_INTERRUPTS)
+void CheckInterruption(ClientContext &context);
+
+// Sleep durations are carried as int64 microseconds and clamped to [0, MAX_SLEEP_MICROS]
+int64_t ClampSleepMicros(int64_t micros);
+
+// Validates a duration in seconds: NaN is rejected, infinite and overly long durations are capped and
+// non-positive durations become zero; fractions of a microsecond are rounded up
+int64_t SecondsToSleepMicros(double seconds);
+
+// Converts an interval to a clamped sleep duration, approximating months as 30 days like PostgreSQL
+// The conversion is exact and cannot overflow for any interval
+int64_t IntervalToSleepMicros(const interval_t &interval);
+
+// Blocks the calling thread until the clock reaches the absolute deadline (in nanoseconds),
+// throwing InterruptException if the query is interrupted; the VIRTUAL clock is advanced to the deadline instead
+void PerformSleepUntil(ClientContext &context, SleepClock clock, int64_t deadline_ns);
+
+// Variant for waits outside of any query (e.g. file I/O of a checkpoint), where there is no client context
+// The wait cannot be interrupted and is not parked on the timer service
+void PerformSleepUntil(DatabaseInstance &db, SleepClock clock, int64_t deadline_ns);
+
+// Blocks the calling thread for the given number of microseconds, multiplied by sleep_time_scale, on the clock
+// selected by sleep_clock
+void PerformSleep(ClientContext &context, int64_t micros);
+
+// Collects the durations of one chunk and sleeps according to the sleep_vector_mode
+// In SERIAL mode every Add sleeps immediately, the other modes sleep once in Finish
+class ChunkSleep {
+public:
+	ChunkSleep(ClientContext &context, SleepVectorMode mode);
+
+	void Add(int64_t micros);
+	//! Adds the same duration for count rows
+	void AddConstant(int64_t micros, idx_t count);
+	//! Adds an absolute deadline in nanoseconds on the sleep_until clock
+	void AddDeadline(int64_t deadline_ns);
+	//! Reads the clock that sleep_until deadlines are measured on
+	int64_t UntilNow() const {
+		return SleepClockNow(context, until_clock);
+	}
+	//! Converts a sleep_until target to a deadline, applying sleep_time_scale to its distance from the query start
+	int64_t TargetToDeadline(timestamp_t target, int64_t now_ns) const;
+	//! Targets at or before the returned timestamp (in microseconds) need no wait
+	int64_t PendingThreshold(int64_t now_ns) const;
+	void Finish();
+
+private:
+	ClientContext &context;
+	SleepVectorMode mode;
+	SleepClock until_clock;
+	double time_scale;
+	//! Whether sleep_until targets are scaled, relative to origin_micros (the start of the transaction)
+	bool scale_targets = false;
+	int64_t origin_micros = 0;
+	bool has_value = false;
+	//! Aggregated duration in microseconds (MAX, SUM and PER_CHUNK modes)
+	int64_t total = 0;
+	//! Whether total already has the time scale applied (SUM of sleep_until deadlines)
+	bool total_scaled = false;
+	bool has_deadline = false;
+	int64_t deadline = 0;
+};
+
+} // namespace duckdb
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "sleep_engine.hpp"
+#include "sleep_random.hpp"
+#include "sleep_throttle.hpp"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <queue>
+
+namespace duckdb {
+
+class ExtensionLoader;
+
+// Kind of file operation that is delayed
+enum class SleepFileAccess : uint8_t { READ, WRITE, SYNC, SEEK };
+
+// Settings that shape the I/O of one file operation
+struct SleepFileSystemSettings {
+	//! Added to every read, write and sync (sleep_fs_latency)
+	int64_t latency_micros = 0;
+	//! Added to accesses that do not continue where the previous one ended (sleep_fs_seek_latency)
+	int64_t seek_latency_micros = 0;
+	//! Transfer rate shared by all files of the database in bytes per second, 0 for unlimited (sleep_fs_bandwidth)
+	double bandwidth = 0;
+	//! Transfer rate of each connection in bytes per second, 0 for unlimited (sleep_fs_connection_bandwidth)
+	double connection_bandwidth = 0;
+	//! Requests of the database that may be in flight at once, 0 for unlimited (sleep_fs_max_inflight)
+	idx_t max_inflight = 0;
+	//! Distribution of the time to the first byte of a request, added to the latency (sleep_fs_first_byte_latency)
+	bool has_first_byte_latency = false;
+	SleepDistributionSpec first_byte_latency;
+	//! Write rate of the database and of each query in bytes per second, 0 for unlimited (sleep_fs_write_bandwidth,
+	//! sleep_fs_query_write_bandwidth); both may run ahead by the burst in bytes (sleep_fs_write_burst)
+	double write_bandwidth = 0;
+	double query_write_bandwidth = 0;
+	double write_burst = 0;
+	//! Read rate and read requests per second of the database, shared fairly by the connections that read, 0 for
+	//! unlimited (sleep_fs_read_bandwidth, sleep_fs_read_iops)
+	double read_bandwidth = 0;
+	double read_iops = 0;
+	//! Share of the connection relative to the others (sleep_fs_read_weight)
+	double read_weight = 1;
+	//! Seconds of its share a connection that has been idle may read at once (sleep_fs_read_burst)
+	double read_burst = 0.1;
+	SleepClock clock = SleepClock::MONOTONIC;
+	double time_scale = 1.0;
+};
+
+// Request counters of one query, all times in microseconds
+struct SleepFileSystemQueryStatistics {
+	uint64_t requests = 0;
+	uint64_t bytes = 0;
+	//! Time spent waiting for a free in-flight slot
+	uint64_t queued_us = 0;
+	//! Time to the first byte, including the latencies
+	uint64_t first_byte_us = 0;
+	//! Total time the requests were delayed
+	uint64_t wait_us = 0;
+	//! Part of the delay spent waiting for the write governor
+	uint64_t write_throttled_us = 0;
+};
+
+// Read counters of one connection, kept for as long as the connection is open
+struct SleepFileSystemReadStatistics {
+	idx_t connection_id = 0;
+	double weight = 1;
+	uint64_t requests = 0;
+	uint64_t bytes = 0;
+	//! Reads held back by the read governor, and the total time all reads were delayed
+	uint64_t throttled = 0;
+	uint64_t wait_us = 0;
+	//! Start of the first read and completion of the last one, on the clock of the last read
+	int64_t first_ns = 0;
+	int64_t last_ns = 0;
+};
+
+// State of slowfs:// for one connection: its throughput cap, the write budget of its current query and the request
+// counters of its queries
+class SleepFileSystemConnectionState : public ClientContextState {
+public:
+	explicit SleepFileSystemConnectionState(idx_t connection_id);
+
+	static shared_ptr<SleepFileSystemConnectionState> Get(ClientContext &context);
+
+	void QueryBegin(ClientContext &context) override;
+	void QueryEnd(ClientContext &context) override;
+	//! Attach the connection to the thread that runs a task of its query, so its file accesses are attributed to it
+	void OnTaskStart(ClientContext &context) override;
+	void OnTaskStop(ClientContext &context) override;
+
+	//! Settings of the current query; they are read once, at the query's first access, instead of on every access
+	bool TryGetQuerySettings(SleepFileSystemSettings &result);
+	void SetQuerySettings(const SleepFileSystemSettings &settings);
+	//! Adds the counters of one access to the current query
+	void Record(const SleepFileSystemQueryStatistics &access);
+	//! Counters of the last query that finished on this connection
+	SleepFileSystemQueryStatistics GetLastQuery();
+	shared_ptr<SleepTokenBucket> GetBandwidthBucket(const SleepFileSystemSettings &settings);
+	//! Write budget of the current query; every query starts with a full burst
+	shared_ptr<SleepTokenBucket> GetQueryWriteBucket(const SleepFileSystemSettings &settings);
+
+	//! Reserves a read on the connection's share of the read rates, returns when it may start
+	int64_t ReserveRead(const SleepFileSystemSettings &settings, double share, int64_t now_ns, idx_t bytes);
+	//! Whether reads of the connection are still waiting for its share at the given time
+	bool IsReadBacklogged(int64_t now_ns);
+	double GetReadWeight();
+	//! Counts a read that was issued at now_ns, held back until admitted_ns and completed at finish_ns
+	void RecordRead(idx_t bytes, int64_t now_ns, int64_t admitted_ns, int64_t finish_ns);
+	SleepFileSystemReadStatistics GetReadStatistics();
+
+	//! Set once the connection takes part in the read governor of the file system
+	std::atomic<bool> read_governed {false};
+
+private:
+	std::mutex lock;
+	bool has_query_settings = false;
+	SleepFileSystemSettings query_settings;
+	SleepFileSystemQueryStatistics current_query;
+	SleepFileSystemQueryStatistics last_query;
+	shared_ptr<SleepTokenBucket> bandwidth_bucket;
+	shared_ptr<SleepTokenBucket> query_write_bucket;
+	SleepFileSystemReadStatistics read_statistics;
+	shared_ptr<SleepTokenBucket> read_bandwidth_bucket;
+	shared_ptr<SleepTokenBucket> read_iops_bucket;
+};
+
+// Handle of a file opened through slowfs://, wrapping the handle of the underlying file system
+class SleepFileHandle : public FileHandle {
+public:
+	SleepFileHandle(FileSystem &file_system, const string &path, FileOpenFlags flags, unique_ptr<FileHandle> inner);
+
+	void Close() override {
+		inner->Close();
+	}
+
+	unique_ptr<FileHandle> inner;
+	//! Offset just past the previous access; an access anywhere else pays the seek latency
+	std::atomic<idx_t> next_offset {0};
+};
+
+// File system that serves paths prefixed with slowfs:// from the rest of the database's file system, delaying
+// reads, writes, seeks and syncs to simulate slower storage
+// Delays are waits on the sleep engine: they follow sleep_clock and sleep_time_scale and can be interrupted
+// Every access is attributed to the connection whose query the calling thread works on, whichever connection opened
+// the file: its settings apply, its interrupts end the wait and its statistics count the access
+// Accesses outside of any query (e.g. a checkpoint in the background) wait uninterruptibly with the global settings
+class SleepFileSystem : public FileSystem {
+public:
+	static constexpr const char *PREFIX = "slowfs://";
+
+	explicit SleepFileSystem(DatabaseInstance &db);
+
+	unique_ptr<FileHandle> OpenFile(const string &path, FileOpenFlags flags,
+	                                optional_ptr<FileOpener> opener = nullptr) override;
+
+	void Read(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) override;
+	void Write(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) override;
+	int64_t Read(FileHandle &handle, void *buffer, int64_t nr_bytes) override;
+	int64_t Write(FileHandle &handle, void *buffer, int64_t nr_bytes) override;
+	bool Trim(FileHandle &handle, idx_t offset_bytes, idx_t length_bytes) override;
+	int64_t GetFileSize(FileHandle &handle) override;
+	timestamp_t GetLastModifiedTime(FileHandle &handle) override;
+	FileType GetFileType(FileHandle &handle) override;
+	void Truncate(FileHandle &handle, int64_t new_size) override;
+	void FileSync(FileHandle &handle) override;
+	void Seek(FileHandle &handle, idx_t location) override;
+	void Reset(FileHandle &handle) override;
+	idx_t SeekPosition(FileHandle &handle) override;
+	bool CanSeek() override {
+		return true;
+	}
+	bool OnDiskFile(FileHandle &handle) override;
+
+	bool DirectoryExists(const string &directory, optional_ptr<FileOpener> opener = nullptr) override;
+	void CreateDirectory(const string &directory, optional_ptr<FileOpener> opener = nullptr) override;
+	void RemoveDirectory(const string &directory, optional_ptr<FileOpener> opener = nullptr) override;
+	bool ListFiles(const string &directory, const std::function<void(const string &, bool)> &callback,
+	               FileOpener *opener = nullptr) override;
+	void MoveFile(const string &source, const string &target, optional_ptr<FileOpener> opener = nullptr) override;
+	bool FileExists(const string &filename, optional_ptr<FileOpener> opener = nullptr) override;
+	bool IsPipe(const string &filename, optional_ptr<FileOpener> opener = nullptr) override;
+	void RemoveFile(const string &filename, optional_ptr<FileOpener> opener = nullptr) override;
+	vector<OpenFileInfo> Glob(const string &path, FileOpener *opener = nullptr) override;
+
+	bool CanHandleFile(const string &fpath) override;
+	string GetName() const override {
+		return "SleepFileSystem";
+	}
+
+	//! Read counters of the open connections that read through slowfs://
+	vector<SleepFileSystemReadStatistics> GetReadStatistics();
+
+private:
+	//! Removes the slowfs:// prefix, leaving a path for the rest of the file system
+	static string StripPrefix(const string &path);
+	SleepFileSystemSettings GetSettings(optional_ptr<ClientContext> context);
+	//! Waits for the write governor, the latency of an access (and the seek latency when it is a random access) and
+	//! the transfer of its bytes
+	void Delay(SleepFileAccess kind, idx_t bytes, bool random_access);
+	//! Weighted fair queueing of reads: returns when a read of the connection may start
+	int64_t GovernRead(ClientContext &context, SleepFileSystemConnectionState &connection,
+	                   const SleepFileSystemSettings &settings, int64_t now_ns, idx_t bytes);
+
+	DatabaseInstance &db;
+	std::mutex lock;
+	//! Models the bandwidth of the simulated device, shared by all files
+	shared_ptr<SleepTokenBucket> bandwidth_bucket;
+	//! Write budget of the database, shared by all queries and by writes outside of a query such as checkpoints
+	shared_ptr<SleepTokenBucket> write_bucket;
+	//! Times at which the requests in flight complete, the earliest on top
+	std::priority_queue<int64_t, vector<int64_t>, std::greater<int64_t>> inflight;
+	SleepClock inflight_clock = SleepClock::MONOTONIC;
+	//! Draws first-byte latencies; the parsed distribution is cached with the setting it came from
+	SleepRandomGenerator generator;
+	string first_byte_spec;
+	SleepDistributionSpec first_byte_latency;
+	//! Connections taking part in the read governor; closed connections are dropped while it is searched
+	std::mutex governor_lock;
+	vector<weak_ptr<SleepFileSystemConnectionState>> read_flows;
+};
+
+struct SleepFileSystemStatistics {
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	uint64_t syncs = 0;
+	//! Accesses that paid the seek latency
+	uint64_t seeks = 0;
+	uint64_t bytes_read = 0;
+	uint64_t bytes_written = 0;
+	//! Time spent waiting on the simulated storage
+	uint64_t wait_total_us = 0;
+	//! Reads, writes and syncs, and the time they spent waiting for an in-flight slot and for their first byte
+	uint64_t requests = 0;
+	uint64_t queued_total_us = 0;
+	uint64_t first_byte_total_us = 0;
+	//! Writes held back by the write governor, and for how long in total
+	uint64_t write_throttles = 0;
+	uint64_t write_throttled_total_us = 0;
+	//! Reads held back by the read governor, and for how long in total
+	uint64_t read_throttles = 0;
+	uint64_t read_throttled_total_us = 0;
+};
+
+SleepFileSystemStatistics GetSleepFileSystemStatistics();
+
+// Registers the slowfs:// file system with the database, sleep_fs_query_stats() and sleep_fs_read_stats()
+void RegisterSleepFileSystem(ExtensionLoader &loader);
+
+} // namespace duckdb
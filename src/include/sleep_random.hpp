@@ -0,0 +1,50 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+class ExtensionLoader;
+
+// xoshiro256++ pseudo-random generator, seeded through splitmix64
+// Small and fast enough to draw a full chunk of samples in a tight loop; each expression state owns one
+class SleepRandomGenerator {
+public:
+	explicit SleepRandomGenerator(uint64_t seed);
+
+	uint64_t Next();
+	//! Uniform double in (0, 1], safe to pass to log and pow
+	double NextUnit() {
+		return static_cast<double>((Next() >> 11) + 1) * (1.0 / 9007199254740992.0);
+	}
+	//! Uniform integer in [0, bound) via Lemire's multiply-shift, without a division
+	uint32_t NextBounded(uint32_t bound) {
+		return static_cast<uint32_t>(((Next() >> 32) * bound) >> 32);
+	}
+
+private:
+	uint64_t state[4];
+};
+
+// Distributions of sleep_random; p1 and p2 are the distribution's parameters as documented in the README
+enum class SleepDistribution : uint8_t { UNIFORM, EXPONENTIAL, NORMAL, LOGNORMAL, PARETO, WEIBULL };
+
+SleepDistribution ParseSleepDistribution(const string &name);
+// Throws if the parameters are not valid for the distribution, naming the function or setting they came from
+void ValidateSleepDistribution(const string &function_name, SleepDistribution distribution, double p1, double p2);
+// Fills out with count samples in seconds
+void DrawSleepSamples(SleepRandomGenerator &generator, SleepDistribution distribution, double p1, double p2,
+                      double *out, idx_t count);
+
+struct SleepDistributionSpec {
+	SleepDistribution distribution;
+	double p1;
+	double p2;
+};
+
+// Parses a distribution given as a string, e.g. 'lognormal(-3, 0.5)' or 'exponential(0.02)', for settings
+SleepDistributionSpec ParseSleepDistributionSpec(const string &setting_name, const string &spec);
+
+void RegisterRandomSleepFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
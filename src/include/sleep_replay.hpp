@@ -0,0 +1,11 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+class ExtensionLoader;
+
+void RegisterReplayFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
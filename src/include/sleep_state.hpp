@@ -0,0 +1,52 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "sleep_engine.hpp"
+#include "sleep_throttle.hpp"
+
+#include <atomic>
+
+namespace duckdb {
+
+// Simulated wall clock of sleep_clock = 'virtual', in nanoseconds since the epoch
+// Sleeps move it forward instead of blocking; sleeps that run concurrently overlap just like real ones would
+class SleepVirtualClock {
+public:
+	explicit SleepVirtualClock(int64_t start_ns) : now_ns(start_ns) {
+	}
+
+	int64_t Now() const {
+		return now_ns.load(std::memory_order_acquire);
+	}
+
+	//! Moves the clock forward to the deadline if it is not there yet, returns how far it moved
+	int64_t AdvanceTo(int64_t deadline_ns) {
+		auto current = now_ns.load(std::memory_order_acquire);
+		while (deadline_ns > current &&
+		       !now_ns.compare_exchange_weak(current, deadline_ns, std::memory_order_acq_rel)) {
+		}
+		return MaxValue<int64_t>(deadline_ns - current, 0);
+	}
+
+private:
+	std::atomic<int64_t> now_ns;
+};
+
+// State of the sleep extension shared by all connections of one database
+class SleepDatabaseState {
+public:
+	explicit SleepDatabaseState(int64_t start_ns);
+
+	//! Returns the state of the context's database, creating it on first use
+	//! The reference stays valid for as long as the database is open
+	//! The connection keeps the state once it has been looked up, so only its first lookup takes the registry lock
+	static SleepDatabaseState &Get(ClientContext &context);
+	static SleepDatabaseState &Get(DatabaseInstance &db);
+
+	//! Starts at the wall-clock time the state was created
+	SleepVirtualClock virtual_clock;
+	//! Buckets of the keyed rate limiters (throttle with a key and throttle_key), shared by all queries
+	SleepBucketMap throttle_buckets;
+};
+
+} // namespace duckdb
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/string_map_set.hpp"
+#include "sleep_engine.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace duckdb {
+
+class ExtensionLoader;
+
+// Lock-free token bucket in GCRA form: instead of a token count it keeps the theoretical arrival time (TAT) at which
+// the bucket is drained again, so reserving tokens is a single compare-and-swap shared by all threads
+// Times are nanoseconds on the bucket's clock; sleeps on the virtual clock advance it like any other sleep
+class SleepTokenBucket {
+public:
+	//! A time_scale below one raises the rate accordingly, like it shortens sleeps
+	SleepTokenBucket(SleepClock clock, double tokens_per_second, double burst, double time_scale);
+
+	struct Reservation {
+		//! The tokens may be used once the clock reaches this time
+		int64_t ready_ns;
+		//! Number of tokens reserved before this reservation
+		uint64_t first_token;
+	};
+
+	//! Reserves count tokens; the caller waits until ready_ns before using them
+	Reservation Reserve(int64_t now_ns, idx_t count);
+	//! Changes the rate and burst for future reservations, nothing is written if they are unchanged
+	//! Callers serialize Configure, e.g. under the lock of the map or state that owns the bucket
+	void Configure(double tokens_per_second, double burst, double time_scale);
+
+	//! Reads the bucket's clock
+	int64_t Now(ClientContext &context) const {
+		return SleepClockNow(context, clock);
+	}
+	//! Whether all reservations lie at least idle_ns in the past; such a bucket behaves exactly like a new one
+	bool IsIdle(int64_t now_ns, int64_t idle_ns) const {
+		return arrival_ns.load(std::memory_order_relaxed) + idle_ns < now_ns;
+	}
+
+	const SleepClock clock;
+
+private:
+	std::atomic<int64_t> arrival_ns;
+	std::atomic<uint64_t> tokens;
+	//! Cost of a single token in nanoseconds
+	std::atomic<double> token_ns;
+	//! How far the TAT may run ahead of the clock without waiting: burst tokens
+	std::atomic<int64_t> tolerance_ns;
+	//! Parameters of the last Configure call
+	double configured_rate;
+	double configured_burst;
+	double configured_time_scale;
+};
+
+// Concurrent map from key to token bucket, split into shards with their own lock so that lookups from different
+// threads rarely contend; buckets that went idle are dropped while the shard is searched anyway
+class SleepBucketMap {
+public:
+	static constexpr idx_t SHARD_COUNT = 64;
+	//! Buckets whose reservations all lie this far (one minute) in the past are expired
+	static constexpr int64_t IDLE_EXPIRY_NS = 60 * NANOS_PER_SECOND;
+	//! Lookups of a shard between two sweeps for idle buckets
+	static constexpr idx_t SWEEP_INTERVAL = 1024;
+
+	//! Returns the bucket of the key, applying the rate and burst to it
+	//! A bucket that was created on another clock is replaced, as its arrival times are not comparable
+	//! The key is hashed and compared in place, only a newly created bucket copies it
+	shared_ptr<SleepTokenBucket> Get(ClientContext &context, string_t key, SleepClock clock, double tokens_per_second,
+	                                 double burst, double time_scale);
+	//! Number of buckets currently kept
+	idx_t Size();
+
+private:
+	struct Entry {
+		//! Owns the key the shard's map refers to
+		string key;
+		shared_ptr<SleepTokenBucket> bucket;
+	};
+
+	struct Shard {
+		std::mutex lock;
+		string_map_t<unique_ptr<Entry>> buckets;
+		idx_t lookups = 0;
+	};
+
+	void Sweep(ClientContext &context, Shard &shard);
+
+	Shard shards[SHARD_COUNT];
+};
+
+// Validates a rate limit: positive and finite
+double ValidateThrottleRate(const string &function_name, double tokens_per_second);
+
+// Reserves count tokens and sleeps on the interruptible path until they are available
+// Returns the number of tokens reserved before this call
+uint64_t ThrottleAcquire(ClientContext &context, SleepTokenBucket &bucket, idx_t count);
+
+struct SleepThrottleStatistics {
+	//! Tokens (rows or bytes) that passed through a bucket
+	uint64_t tokens = 0;
+	//! Reservations that had to wait, and for how long in total
+	uint64_t waits = 0;
+	uint64_t wait_total_us = 0;
+	//! Keyed buckets dropped after going idle
+	uint64_t buckets_expired = 0;
+};
+
+SleepThrottleStatistics GetSleepThrottleStatistics();
+
+void RegisterThrottleFunctions(ExtensionLoader &loader);
+
+} // namespace duckdb
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/parallel/interrupt.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <unordered_set>
+
+namespace duckdb {
+
+enum class SleepTimerFireReason : uint8_t { EXPIRED, INTERRUPTED };
+
+// A pending deadline owned by the SleepTimerService while it is armed
+// Timers are linked intrusively into the wheel slots, so arming and cancelling never allocate
+class SleepTimer {
+public:
+	explicit SleepTimer(optional_ptr<ClientContext> context = nullptr) : context(context) {
+	}
+	virtual ~SleepTimer() = default;
+
+	// Invoked on the service thread with the service lock held once the timer expires or its context is interrupted
+	// The timer is already disarmed when this is called; implementations must not block or call back into the service
+	// Task callbacks that may block (Executor::RescheduleTask takes the executor lock) are instead appended to
+	// `reschedule` as copies, the service invokes them after releasing its lock so the timer may be destroyed by then
+	virtual void Fire(SleepTimerFireReason reason, vector<InterruptState> &reschedule) = 0;
+
+	bool IsArmed() const {
+		return slot != nullptr;
+	}
+
+	//! The context whose interruption fires this timer early (optional)
+	optional_ptr<ClientContext> context;
+
+private:
+	friend class SleepTimerService;
+
+	SleepTimer *prev = nullptr;
+	SleepTimer *next = nullptr;
+	SleepTimer **slot = nullptr;
+	uint64_t expiry_tick = 0;
+	//! Links of the armed timers that have a context, whose interrupt flags the service polls
+	SleepTimer *watch_prev = nullptr;
+	SleepTimer *watch_next = nullptr;
+};
+
+struct SleepTimerStatistics {
+	uint64_t armed = 0;
+	uint64_t total_armed = 0;
+	uint64_t expired = 0;
+	uint64_t interrupted = 0;
+	uint64_t cancelled = 0;
+	uint64_t cascaded = 0;
+	uint64_t ticks = 0;
+	//! Times the service thread woke up to expire timers or poll interrupts
+	uint64_t wakeups = 0;
+	uint64_t watched_contexts = 0;
+};
+
+// Extension-wide hierarchical timing wheel that owns the deadlines of all pending sleeps
+// A single service thread sleeps until the next occupied slot comes due, skipping empty ticks in bulk, and fires
+// exactly the timers whose deadlines expired
+// ClientContext::Interrupt only raises a flag and notifies nobody, so while timers with a context are armed the service
+// also wakes every INTERRUPT_POLL_MICROS to check the flags of just those timers, which it keeps in a list of their
+// own; this one poll on the service thread replaces the per-sleep polling loops, the sleeping threads stay parked until
+// their timer fires
+class SleepTimerService {
+public:
+	using time_point_t = std::chrono::steady_clock::time_point;
+
+	//! Wheel resolution: deadlines are rounded up to the next tick boundary
+	static constexpr int64_t TICK_MICROS = 1000;
+	static constexpr idx_t SLOT_BITS = 6;
+	static constexpr idx_t SLOTS_PER_LEVEL = idx_t(1) << SLOT_BITS;
+	static constexpr idx_t SLOT_MASK = SLOTS_PER_LEVEL - 1;
+	//! Four levels of 64 slots cover 2^24 ticks (~4.6 hours at 1 ms per tick)
+	static constexpr idx_t LEVEL_COUNT = 4;
+	static constexpr uint64_t MAX_TICK_DELTA = (uint64_t(1) << (SLOT_BITS * LEVEL_COUNT)) - 1;
+	//! Interval at which the interrupt flags of contexts with armed timers are checked (0.5 ms), which bounds the
+	//! latency of a cancellation
+	static constexpr int64_t INTERRUPT_POLL_MICROS = 500;
+
+	~SleepTimerService();
+
+	static SleepTimerService &Get();
+
+	//! Starts the service thread if it is not running yet
+	void Start();
+	//! Arms the timer so it fires at the first tick boundary at or after the deadline
+	//! Deadlines further out than the wheel span fire early; callers re-arm for the remainder
+	void Arm(SleepTimer &timer, time_point_t deadline);
+	//! Disarms the timer, returns false if it already fired
+	bool Cancel(SleepTimer &timer);
+
+	SleepTimerStatistics GetStatistics();
+
+	static std::chrono::steady_clock::duration TickDuration() {
+		return std::chrono::microseconds(TICK_MICROS);
+	}
+
+private:
+	SleepTimerService();
+
+	void Run();
+	uint64_t TickAt(time_point_t time) const;
+	time_point_t TimeOfTick(uint64_t tick) const;
+	void Insert(SleepTimer &timer);
+	void Unlink(SleepTimer &timer);
+	void Disarm(SleepTimer &timer);
+	void Advance(uint64_t target_tick);
+	//! First tick after the current one at which an occupied slot expires or cascades, or NO_TICK when empty
+	uint64_t NextEventTick() const;
+	void Cascade(idx_t level);
+	void ExpireSlot(SleepTimer *&slot);
+	void PollInterrupts();
+	//! Invokes the task callbacks collected while firing timers, with the service lock released
+	void RunCallbacks(std::unique_lock<std::mutex> &guard);
+
+private:
+	std::mutex lock;
+	std::condition_variable cv;
+	std::thread thread;
+	bool shutdown = false;
+
+	time_point_t epoch;
+	uint64_t current_tick = 0;
+	SleepTimer *wheel[LEVEL_COUNT][SLOTS_PER_LEVEL] = {};
+	//! One bit per non-empty slot of each level, so the next occupied slot is found without scanning
+	uint64_t occupied[LEVEL_COUNT] = {};
+	//! When the service thread is going to wake up next; arming an earlier timer wakes it right away
+	time_point_t next_wakeup = time_point_t::max();
+	time_point_t next_interrupt_poll;
+	//! Armed timers that have a context; only these are visited when the interrupt flags are polled
+	SleepTimer *watched = nullptr;
+	//! Task callbacks of fired timers that still have to run outside of the lock
+	vector<InterruptState> pending_callbacks;
+
+	SleepTimerStatistics stats;
+};
+
+} // namespace duckdb
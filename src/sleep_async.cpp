@@ -0,0 +1,370 @@
+#include "sleep_async.hpp"
+#include "sleep_engine.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+
+#include <chrono>
+
+namespace duckdb {
+
+static constexpr const char *SLEEP_ASYNC_NAME = "sleep_async";
+static constexpr const char *TICKER_NAME = "ticker";
+
+// Due times are capped this far (about 146 years) after the start of a scan, so adding them to a clock cannot overflow
+static constexpr int64_t MAX_DUE_OFFSET_NS = NumericLimits<int64_t>::Maximum() / 2;
+
+//===--------------------------------------------------------------------===//
+// Bind
+//===--------------------------------------------------------------------===//
+
+// Table functions whose rows are released on a schedule measured from the start of the scan
+enum class ScheduledSourceKind : uint8_t {
+	//! sleep_async: a single row (woke_at) once the duration has passed
+	SLEEP_ASYNC,
+	//! ticker: one row (tick, scheduled_at, fired_at) per interval
+	TICKER
+};
+
+struct ScheduledSourceBindData : public TableFunctionData {
+	ScheduledSourceBindData(ScheduledSourceKind kind, int64_t interval_micros, idx_t count)
+	    : kind(kind), interval_micros(interval_micros), count(count) {
+	}
+
+	ScheduledSourceKind kind;
+	//! Row i is due (i + 1) * interval_micros after the start of the scan, before applying sleep_time_scale
+	int64_t interval_micros;
+	idx_t count;
+};
+
+static int64_t DurationToSleepMicros(const Value &duration) {
+	if (duration.IsNull()) {
+		return 0;
+	}
+	if (duration.type().id() == LogicalTypeId::INTERVAL) {
+		return IntervalToSleepMicros(duration.GetValue<interval_t>());
+	}
+	return SecondsToSleepMicros(duration.GetValue<double>());
+}
+
+static unique_ptr<FunctionData> SleepAsyncBind(ClientContext &context, TableFunctionBindInput &input,
+                                               vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("woke_at");
+	return_types.emplace_back(LogicalType::TIMESTAMP);
+	return make_uniq<ScheduledSourceBindData>(ScheduledSourceKind::SLEEP_ASYNC,
+	                                          DurationToSleepMicros(input.inputs[0]), 1);
+}
+
+static unique_ptr<FunctionData> TickerBind(ClientContext &context, TableFunctionBindInput &input,
+                                           vector<LogicalType> &return_types, vector<string> &names) {
+	auto &count = input.inputs[1];
+	auto ticks = count.IsNull() ? 0 : count.GetValue<int64_t>();
+	names.emplace_back("tick");
+	return_types.emplace_back(LogicalType::BIGINT);
+	names.emplace_back("scheduled_at");
+	return_types.emplace_back(LogicalType::TIMESTAMP);
+	names.emplace_back("fired_at");
+	return_types.emplace_back(LogicalType::TIMESTAMP);
+	return make_uniq<ScheduledSourceBindData>(ScheduledSourceKind::TICKER, DurationToSleepMicros(input.inputs[0]),
+	                                          ticks > 0 ? static_cast<idx_t>(ticks) : 0);
+}
+
+//===--------------------------------------------------------------------===//
+// Schedule
+//===--------------------------------------------------------------------===//
+
+// Progress of one scan through its schedule
+// Every due time is derived from the anchor taken when the scan starts, so late wake-ups never accumulate into drift
+class ScanSchedule {
+public:
+	ScanSchedule(ClientContext &context, const ScheduledSourceBindData &bind_data, int64_t anchor_ns)
+	    : bind_data(bind_data), time_scale(GetSleepTimeScale(context)), anchor_ns(anchor_ns),
+	      anchor(SleepTimestampNow(context)) {
+	}
+
+	const ScheduledSourceBindData &bind_data;
+	double time_scale;
+	//! Start of the scan on the clock that deadlines are measured on, and on the sleep_now() clock
+	int64_t anchor_ns;
+	timestamp_t anchor;
+	idx_t next_row = 0;
+
+	bool Finished() const {
+		return next_row >= bind_data.count;
+	}
+	//! Distance of a row's due time from the anchor in nanoseconds, with sleep_time_scale applied
+	int64_t DueOffset(idx_t row) const {
+		auto offset = static_cast<double>(row + 1) * static_cast<double>(bind_data.interval_micros) *
+		              static_cast<double>(NANOS_PER_MICRO) * time_scale;
+		return offset < static_cast<double>(MAX_DUE_OFFSET_NS) ? static_cast<int64_t>(offset) : MAX_DUE_OFFSET_NS;
+	}
+	int64_t Deadline(idx_t row) const {
+		return anchor_ns + DueOffset(row);
+	}
+
+	//! Writes the next row to position out_row of the chunk; columns maps each output column to a function column
+	void Emit(DataChunk &chunk, idx_t out_row, const vector<idx_t> &columns, timestamp_t fired_at) {
+		auto row = next_row++;
+		for (idx_t col_idx = 0; col_idx < columns.size(); col_idx++) {
+			chunk.SetValue(col_idx, out_row, GetValue(columns[col_idx], row, fired_at, chunk.data[col_idx].GetType()));
+		}
+	}
+
+private:
+	Value GetValue(idx_t column, idx_t row, timestamp_t fired_at, const LogicalType &type) const {
+		if (bind_data.kind == ScheduledSourceKind::SLEEP_ASYNC) {
+			return column == 0 ? Value::TIMESTAMP(fired_at) : Value(type);
+		}
+		switch (column) {
+		case 0:
+			return Value::BIGINT(static_cast<int64_t>(row));
+		case 1:
+			return Value::TIMESTAMP(timestamp_t(anchor.value + DueOffset(row) / NANOS_PER_MICRO));
+		case 2:
+			return Value::TIMESTAMP(fired_at);
+		default:
+			// Row-id style columns requested by the planner
+			return Value(type);
+		}
+	}
+};
+
+//===--------------------------------------------------------------------===//
+// Blocking Fallback
+//===--------------------------------------------------------------------===//
+
+struct ScheduledSourceFallbackState : public GlobalTableFunctionState {
+	ScheduledSourceFallbackState(ClientContext &context, const ScheduledSourceBindData &bind_data, SleepClock clock)
+	    : clock(clock), schedule(context, bind_data, SleepClockNow(context, clock)) {
+	}
+
+	SleepClock clock;
+	ScanSchedule schedule;
+	vector<idx_t> columns;
+};
+
+static unique_ptr<GlobalTableFunctionState> ScheduledSourceFallbackInit(ClientContext &context,
+                                                                        TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<ScheduledSourceBindData>();
+	auto result = make_uniq<ScheduledSourceFallbackState>(context, bind_data, GetSleepClock(context));
+	auto column_count = bind_data.kind == ScheduledSourceKind::TICKER ? 3 : 1;
+	for (idx_t col_idx = 0; col_idx < static_cast<idx_t>(column_count); col_idx++) {
+		result->columns.push_back(col_idx);
+	}
+	return std::move(result);
+}
+
+// Only reached when the optimizer did not swap the scan for PhysicalScheduledSource (e.g. with the optimizer
+// disabled): the worker thread blocks until each row is due
+static void ScheduledSourceFallbackFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<ScheduledSourceFallbackState>();
+	auto &schedule = state.schedule;
+	if (schedule.Finished()) {
+		return;
+	}
+	PerformSleepUntil(context, state.clock, schedule.Deadline(schedule.next_row));
+	schedule.Emit(output, 0, state.columns, SleepTimestampNow(context));
+	output.SetCardinality(1);
+}
+
+//===--------------------------------------------------------------------===//
+// Physical Operator
+//===--------------------------------------------------------------------===//
+
+class ScheduledSourceGlobalState : public GlobalSourceState {
+public:
+	ScheduledSourceGlobalState(ClientContext &context, const ScheduledSourceBindData &bind_data, bool virtual_clock,
+	                           int64_t anchor_ns)
+	    : virtual_clock(virtual_clock), schedule(context, bind_data, anchor_ns) {
+	}
+
+	//! On the virtual clock due times are reached by advancing it, otherwise they are steady-clock times
+	bool virtual_clock;
+	ScanSchedule schedule;
+};
+
+class ScheduledSourceLocalState : public LocalSourceState {
+public:
+	explicit ScheduledSourceLocalState(ClientContext &context) : timer(context) {
+	}
+
+	AsyncSleepTimer timer;
+};
+
+// Source that emits its rows as they come due (sleep_async and ticker)
+// While waiting it arms an AsyncSleepTimer and returns BLOCKED, releasing the worker thread back to the scheduler
+// Each chunk holds the rows that are due when it is produced, normally one, so every row reaches the client on time
+class PhysicalScheduledSource : public PhysicalOperator {
+public:
+	static constexpr const PhysicalOperatorType TYPE = PhysicalOperatorType::EXTENSION;
+
+	PhysicalScheduledSource(PhysicalPlan &physical_plan, vector<LogicalType> types, ScheduledSourceBindData bind_data,
+	                        vector<idx_t> columns)
+	    : PhysicalOperator(physical_plan, PhysicalOperatorType::EXTENSION, std::move(types), bind_data.count),
+	      bind_data(std::move(bind_data)), columns(std::move(columns)) {
+	}
+
+	ScheduledSourceBindData bind_data;
+	//! Function column of each output column; row-id style columns are emitted as NULL
+	vector<idx_t> columns;
+
+public:
+	string GetName() const override {
+		return bind_data.kind == ScheduledSourceKind::TICKER ? "TICKER" : "SLEEP_ASYNC";
+	}
+
+	bool IsSource() const override {
+		return true;
+	}
+
+	unique_ptr<GlobalSourceState> GetGlobalSourceState(ClientContext &context) const override {
+		if (GetSleepClock(context) == SleepClock::VIRTUAL) {
+			return make_uniq<ScheduledSourceGlobalState>(context, bind_data, true,
+			                                             SleepClockNow(context, SleepClock::VIRTUAL));
+		}
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return make_uniq<ScheduledSourceGlobalState>(
+		    context, bind_data, false, std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+	}
+
+	unique_ptr<LocalSourceState> GetLocalSourceState(ExecutionContext &context,
+	                                                 GlobalSourceState &gstate) const override {
+		return make_uniq<ScheduledSourceLocalState>(context.client);
+	}
+
+	SourceResultType GetData(ExecutionContext &context, DataChunk &chunk, OperatorSourceInput &input) const override {
+		auto &gstate = input.global_state.Cast<ScheduledSourceGlobalState>();
+		auto &lstate = input.local_state.Cast<ScheduledSourceLocalState>();
+		auto &schedule = gstate.schedule;
+		CheckInterruption(context.client);
+		if (schedule.Finished()) {
+			return SourceResultType::FINISHED;
+		}
+		if (gstate.virtual_clock) {
+			// The virtual clock is advanced right away, leaving nothing to wait for
+			PerformSleepUntil(context.client, SleepClock::VIRTUAL, schedule.Deadline(schedule.next_row));
+			schedule.Emit(chunk, 0, columns, SleepTimestampNow(context.client));
+			chunk.SetCardinality(1);
+			return SourceResultType::HAVE_MORE_OUTPUT;
+		}
+		auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		               std::chrono::steady_clock::now().time_since_epoch())
+		               .count();
+		auto deadline = schedule.Deadline(schedule.next_row);
+		if (now < deadline) {
+			lstate.timer.Arm(input.interrupt_state,
+			                 SleepTimerService::time_point_t(std::chrono::nanoseconds(deadline)));
+			return SourceResultType::BLOCKED;
+		}
+		// Rows that came due while the consumer was busy are caught up in a single chunk
+		auto fired_at = SleepTimestampNow(context.client);
+		idx_t count = 0;
+		while (count < STANDARD_VECTOR_SIZE && !schedule.Finished() && schedule.Deadline(schedule.next_row) <= now) {
+			schedule.Emit(chunk, count++, columns, fired_at);
+		}
+		chunk.SetCardinality(count);
+		return SourceResultType::HAVE_MORE_OUTPUT;
+	}
+};
+
+//===--------------------------------------------------------------------===//
+// Logical Operator
+//===--------------------------------------------------------------------===//
+
+// Replaces the LogicalGet of a sleep_async or ticker scan, keeping its column bindings so the rest of the plan is
+// untouched
+class LogicalScheduledSource : public LogicalExtensionOperator {
+public:
+	explicit LogicalScheduledSource(LogicalGet &get) : bind_data(get.bind_data->Cast<ScheduledSourceBindData>()) {
+		get.ResolveOperatorTypes();
+		bindings = get.GetColumnBindings();
+		output_types = get.types;
+		auto &column_ids = get.GetColumnIds();
+		for (idx_t col_idx = 0; col_idx < bindings.size(); col_idx++) {
+			auto source_idx = get.projection_ids.empty() ? col_idx : get.projection_ids[col_idx];
+			auto primary = column_ids[source_idx].GetPrimaryIndex();
+			columns.push_back(primary < get.returned_types.size() ? primary : DConstants::INVALID_INDEX);
+		}
+		SetEstimatedCardinality(bind_data.count);
+	}
+
+	ScheduledSourceBindData bind_data;
+	vector<ColumnBinding> bindings;
+	vector<LogicalType> output_types;
+	vector<idx_t> columns;
+
+public:
+	vector<ColumnBinding> GetColumnBindings() override {
+		return bindings;
+	}
+
+	PhysicalOperator &CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) override {
+		return planner.Make<PhysicalScheduledSource>(output_types, bind_data, columns);
+	}
+
+	string GetExtensionName() const override {
+		return "sleep";
+	}
+
+protected:
+	void ResolveTypes() override {
+		types = output_types;
+	}
+};
+
+//===--------------------------------------------------------------------===//
+// Optimizer
+//===--------------------------------------------------------------------===//
+
+static void ReplaceScheduledScans(unique_ptr<LogicalOperator> &op) {
+	if (op->type == LogicalOperatorType::LOGICAL_GET) {
+		auto &get = op->Cast<LogicalGet>();
+		if (get.function.name == SLEEP_ASYNC_NAME || get.function.name == TICKER_NAME) {
+			op = make_uniq<LogicalScheduledSource>(get);
+			return;
+		}
+	}
+	for (auto &child : op->children) {
+		ReplaceScheduledScans(child);
+	}
+}
+
+static void SleepAsyncOptimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	ReplaceScheduledScans(plan);
+}
+
+//===--------------------------------------------------------------------===//
+// Registration
+//===--------------------------------------------------------------------===//
+
+void RegisterAsyncSleepFunctions(ExtensionLoader &loader) {
+	// Register sleep_async(seconds) and sleep_async(interval)
+	TableFunctionSet sleep_async(SLEEP_ASYNC_NAME);
+	sleep_async.AddFunction(TableFunction({LogicalType::DOUBLE}, ScheduledSourceFallbackFunction, SleepAsyncBind,
+	                                      ScheduledSourceFallbackInit));
+	sleep_async.AddFunction(TableFunction({LogicalType::INTERVAL}, ScheduledSourceFallbackFunction, SleepAsyncBind,
+	                                      ScheduledSourceFallbackInit));
+	loader.RegisterFunction(sleep_async);
+
+	// Register ticker(seconds, count) and ticker(interval, count)
+	TableFunctionSet ticker(TICKER_NAME);
+	ticker.AddFunction(TableFunction({LogicalType::DOUBLE, LogicalType::BIGINT}, ScheduledSourceFallbackFunction,
+	                                 TickerBind, ScheduledSourceFallbackInit));
+	ticker.AddFunction(TableFunction({LogicalType::INTERVAL, LogicalType::BIGINT}, ScheduledSourceFallbackFunction,
+	                                 TickerBind, ScheduledSourceFallbackInit));
+	loader.RegisterFunction(ticker);
+
+	// Swap sleep_async and ticker scans for a source operator that blocks asynchronously instead of holding a worker thread
+	OptimizerExtension optimizer;
+	optimizer.optimize_function = SleepAsyncOptimize;
+	DBConfig::GetConfig(loader.GetDatabaseInstance()).optimizer_extensions.push_back(std::move(optimizer));
+}
+
+} // namespace duckdb
@@ -0,0 +1,348 @@
+#include "sleep_duty_cycle.hpp"
+#include "sleep_engine.hpp"
+
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+namespace duckdb {
+
+// Debt below this is carried over to the next chunk instead of being slept off, so sleeps stay long enough to be
+// precise
+static constexpr int64_t MIN_DUTY_CYCLE_SLEEP_NS = NANOS_PER_MICRO * 1000;
+// A thread that was away from the pipeline for longer, e.g. because it ran tasks of other pipelines in between,
+// counts at most this much as work and as time spent in the pipeline
+static constexpr int64_t MAX_DUTY_CYCLE_BUSY_NS = NANOS_PER_SECOND;
+
+// CPU time the calling thread has used so far; where it cannot be measured, the steady clock stands in for it
+static int64_t ThreadCpuNanos() {
+#ifdef __linux__
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return static_cast<int64_t>(now.tv_sec) * NANOS_PER_SECOND + now.tv_nsec;
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+#endif
+}
+
+//===--------------------------------------------------------------------===//
+// Statistics
+//===--------------------------------------------------------------------===//
+
+struct SleepDutyCycleCounters {
+	std::atomic<uint64_t> busy_total_us {0};
+	std::atomic<uint64_t> throttled_total_us {0};
+};
+
+static SleepDutyCycleCounters &GetCounters() {
+	static SleepDutyCycleCounters counters;
+	return counters;
+}
+
+SleepDutyCycleStatistics GetSleepDutyCycleStatistics() {
+	auto &counters = GetCounters();
+	SleepDutyCycleStatistics result;
+	result.busy_total_us = counters.busy_total_us.load();
+	result.throttled_total_us = counters.throttled_total_us.load();
+	return result;
+}
+
+// Work and sleep of the threads of one query
+struct SleepDutyCycleQueryStatistics {
+	double target = 1;
+	//! CPU time the threads used in the paced pipelines
+	int64_t busy_ns = 0;
+	//! Wall-clock time the threads spent in the paced pipelines apart from their sleeps, working or blocked
+	int64_t elapsed_ns = 0;
+	int64_t throttled_ns = 0;
+};
+
+// Duty cycle of the current and the last finished query of a connection
+class SleepDutyCycleState : public ClientContextState {
+public:
+	static shared_ptr<SleepDutyCycleState> Get(ClientContext &context) {
+		return context.registered_state->GetOrCreate<SleepDutyCycleState>("sleep_duty_cycle");
+	}
+
+	void QueryBegin(ClientContext &context) override {
+		std::lock_guard<std::mutex> guard(lock);
+		current_query = SleepDutyCycleQueryStatistics();
+	}
+
+	void QueryEnd(ClientContext &context) override {
+		std::lock_guard<std::mutex> guard(lock);
+		last_query = current_query;
+	}
+
+	void Record(double target, int64_t busy_ns, int64_t elapsed_ns, int64_t throttled_ns) {
+		std::lock_guard<std::mutex> guard(lock);
+		current_query.target = target;
+		current_query.busy_ns += busy_ns;
+		current_query.elapsed_ns += elapsed_ns;
+		current_query.throttled_ns += throttled_ns;
+	}
+
+	SleepDutyCycleQueryStatistics GetLastQuery() {
+		std::lock_guard<std::mutex> guard(lock);
+		return last_query;
+	}
+
+private:
+	std::mutex lock;
+	SleepDutyCycleQueryStatistics current_query;
+	SleepDutyCycleQueryStatistics last_query;
+};
+
+//===--------------------------------------------------------------------===//
+// Physical Operator
+//===--------------------------------------------------------------------===//
+
+class DutyCycleOperatorState : public OperatorState {
+public:
+	explicit DutyCycleOperatorState(ClientContext &context)
+	    : last_ns(SleepClockNow(context, SleepClock::MONOTONIC)), last_cpu_ns(ThreadCpuNanos()),
+	      thread(std::this_thread::get_id()) {
+	}
+
+	//! When the thread last left the operator, and its CPU time then; the CPU time it uses until it returns is work
+	//! on the pipeline
+	int64_t last_ns;
+	int64_t last_cpu_ns;
+	std::thread::id thread;
+	//! Sleep owed for the work so far; negative when the previous sleep overshot
+	int64_t debt_ns = 0;
+	int64_t busy_ns = 0;
+	int64_t elapsed_ns = 0;
+	int64_t throttled_ns = 0;
+
+	void Finalize(const PhysicalOperator &op, ExecutionContext &context) override;
+};
+
+// Pass-through operator that makes each worker thread sleep between chunks, so the pipeline uses at most the target
+// fraction of the thread's time: every nanosecond of CPU time owes (1 - target) / target nanoseconds of sleep, while
+// time the thread spends blocked, e.g. waiting for I/O, owes nothing
+// The sleeps are interruptible sleeps on the steady clock; the duty cycle is about real CPU time, so they are neither
+// scaled by sleep_time_scale nor taken on the virtual clock
+class PhysicalDutyCycle : public PhysicalOperator {
+public:
+	static constexpr const PhysicalOperatorType TYPE = PhysicalOperatorType::EXTENSION;
+
+	PhysicalDutyCycle(PhysicalPlan &physical_plan, vector<LogicalType> types, idx_t estimated_cardinality,
+	                  double target)
+	    : PhysicalOperator(physical_plan, PhysicalOperatorType::EXTENSION, std::move(types), estimated_cardinality),
+	      target(target) {
+	}
+
+	double target;
+
+public:
+	string GetName() const override {
+		return "CPU_DUTY_CYCLE";
+	}
+
+	bool ParallelOperator() const override {
+		return true;
+	}
+
+	unique_ptr<OperatorState> GetOperatorState(ExecutionContext &context) const override {
+		return make_uniq<DutyCycleOperatorState>(context.client);
+	}
+
+	//! Adds the work since the thread last left the operator and sleeps off the debt once it is large enough, or all
+	//! of it when the pipeline is done
+	void Pace(ClientContext &context, DutyCycleOperatorState &state, bool final) const {
+		auto now = SleepClockNow(context, SleepClock::MONOTONIC);
+		auto cpu_now = ThreadCpuNanos();
+		auto thread = std::this_thread::get_id();
+		// The CPU clock is per thread: a pipeline that resumed on another thread starts measuring again there
+		int64_t busy = 0;
+		if (thread == state.thread) {
+			busy = MinValue<int64_t>(MaxValue<int64_t>(cpu_now - state.last_cpu_ns, 0), MAX_DUTY_CYCLE_BUSY_NS);
+		}
+		state.busy_ns += busy;
+		state.elapsed_ns += MinValue<int64_t>(MaxValue<int64_t>(now - state.last_ns, 0), MAX_DUTY_CYCLE_BUSY_NS);
+		state.debt_ns += static_cast<int64_t>(static_cast<double>(busy) * (1 - target) / target);
+		if (state.debt_ns >= MIN_DUTY_CYCLE_SLEEP_NS || (final && state.debt_ns > 0)) {
+			PerformSleepUntil(context, SleepClock::MONOTONIC, now + state.debt_ns);
+			auto woke = SleepClockNow(context, SleepClock::MONOTONIC);
+			state.debt_ns -= woke - now;
+			state.throttled_ns += woke - now;
+			now = woke;
+			// A precise sleep spins for its last part; that is not work on the pipeline
+			cpu_now = ThreadCpuNanos();
+		}
+		state.last_ns = now;
+		state.last_cpu_ns = cpu_now;
+		state.thread = thread;
+	}
+
+	OperatorResultType Execute(ExecutionContext &context, DataChunk &input, DataChunk &chunk,
+	                           GlobalOperatorState &gstate, OperatorState &state_p) const override {
+		Pace(context.client, state_p.Cast<DutyCycleOperatorState>(), false);
+		chunk.Reference(input);
+		return OperatorResultType::NEED_MORE_INPUT;
+	}
+};
+
+void DutyCycleOperatorState::Finalize(const PhysicalOperator &op, ExecutionContext &context) {
+	// The last chunk was processed by the rest of the pipeline after it left the operator; that work is paid here
+	op.Cast<PhysicalDutyCycle>().Pace(context.client, *this, true);
+	auto &counters = GetCounters();
+	counters.busy_total_us.fetch_add(static_cast<uint64_t>(busy_ns / NANOS_PER_MICRO), std::memory_order_relaxed);
+	counters.throttled_total_us.fetch_add(static_cast<uint64_t>(throttled_ns / NANOS_PER_MICRO),
+	                                      std::memory_order_relaxed);
+	SleepDutyCycleState::Get(context.client)
+	    ->Record(op.Cast<PhysicalDutyCycle>().target, busy_ns, elapsed_ns, throttled_ns);
+	busy_ns = 0;
+	elapsed_ns = 0;
+	throttled_ns = 0;
+}
+
+//===--------------------------------------------------------------------===//
+// Logical Operator
+//===--------------------------------------------------------------------===//
+
+// Placed on top of a scan, keeping its column bindings so the rest of the plan is untouched
+class LogicalDutyCycle : public LogicalExtensionOperator {
+public:
+	LogicalDutyCycle(unique_ptr<LogicalOperator> child, double target) : target(target) {
+		if (child->has_estimated_cardinality) {
+			SetEstimatedCardinality(child->estimated_cardinality);
+		}
+		children.push_back(std::move(child));
+	}
+
+	double target;
+
+public:
+	vector<ColumnBinding> GetColumnBindings() override {
+		return children[0]->GetColumnBindings();
+	}
+
+	PhysicalOperator &CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) override {
+		auto &child = planner.CreatePlan(*children[0]);
+		auto &duty_cycle = planner.Make<PhysicalDutyCycle>(types, estimated_cardinality, target);
+		duty_cycle.children.push_back(child);
+		return duty_cycle;
+	}
+
+	string GetExtensionName() const override {
+		return "sleep";
+	}
+
+protected:
+	void ResolveTypes() override {
+		types = children[0]->types;
+	}
+};
+
+//===--------------------------------------------------------------------===//
+// Optimizer
+//===--------------------------------------------------------------------===//
+
+// Every pipeline that starts at a scan runs through the operator on top of it
+static void PaceScans(unique_ptr<LogicalOperator> &op, double target) {
+	for (auto &child : op->children) {
+		PaceScans(child, target);
+	}
+	if (op->type == LogicalOperatorType::LOGICAL_GET) {
+		op->ResolveOperatorTypes();
+		op = make_uniq<LogicalDutyCycle>(std::move(op), target);
+		op->ResolveOperatorTypes();
+	}
+}
+
+static void DutyCycleOptimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	Value value;
+	if (!input.context.TryGetCurrentSetting("cpu_duty_cycle", value) || value.IsNull()) {
+		return;
+	}
+	auto target = value.GetValue<double>();
+	if (target < 1) {
+		PaceScans(plan, target);
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// cpu_duty_cycle_stats
+//===--------------------------------------------------------------------===//
+
+struct DutyCycleStatsState : public GlobalTableFunctionState {
+	SleepDutyCycleQueryStatistics stats;
+	bool finished = false;
+};
+
+static unique_ptr<FunctionData> DutyCycleStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("target");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	names.emplace_back("busy_us");
+	return_types.emplace_back(LogicalType::BIGINT);
+	names.emplace_back("throttled_us");
+	return_types.emplace_back(LogicalType::BIGINT);
+	names.emplace_back("duty_cycle");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> DutyCycleStatsInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto result = make_uniq<DutyCycleStatsState>();
+	result->stats = SleepDutyCycleState::Get(context)->GetLastQuery();
+	return std::move(result);
+}
+
+// cpu_duty_cycle_stats()
+// Reports the duty cycle the previous query on this connection was held to and the one it achieved: the CPU time of
+// the paced threads as a fraction of the time they spent in the paced pipelines, sleeps included; NULL when no
+// pipeline was paced
+static void DutyCycleStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<DutyCycleStatsState>();
+	if (state.finished) {
+		return;
+	}
+	state.finished = true;
+	auto &stats = state.stats;
+	output.SetValue(0, 0, Value::DOUBLE(stats.target));
+	output.SetValue(1, 0, Value::BIGINT(stats.busy_ns / NANOS_PER_MICRO));
+	output.SetValue(2, 0, Value::BIGINT(stats.throttled_ns / NANOS_PER_MICRO));
+	auto total_ns = stats.elapsed_ns + stats.throttled_ns;
+	if (total_ns > 0) {
+		output.SetValue(3, 0, Value::DOUBLE(static_cast<double>(stats.busy_ns) / static_cast<double>(total_ns)));
+	} else {
+		output.SetValue(3, 0, Value());
+	}
+	output.SetCardinality(1);
+}
+
+//===--------------------------------------------------------------------===//
+// Registration
+//===--------------------------------------------------------------------===//
+
+void RegisterDutyCycleFunctions(ExtensionLoader &loader) {
+	// Register cpu_duty_cycle_stats()
+	TableFunction stats("cpu_duty_cycle_stats", {}, DutyCycleStatsFunction, DutyCycleStatsBind, DutyCycleStatsInit);
+	loader.RegisterFunction(stats);
+
+	// Pace the scans of queries on connections with a cpu_duty_cycle below one
+	OptimizerExtension optimizer;
+	optimizer.optimize_function = DutyCycleOptimize;
+	DBConfig::GetConfig(loader.GetDatabaseInstance()).optimizer_extensions.push_back(std::move(optimizer));
+}
+
+} // namespace duckdb
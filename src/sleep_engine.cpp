@@ -0,0 +1,688 @@
+#include "sleep_engine.hpp"
+#include "sleep_state.hpp"
+#include "sleep_timer_service.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/limits.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/transaction/meta_transaction.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// Helper Functions
+//===--------------------------------------------------------------------===//
+
+// Check for query cancellation (similar to PostgreSQL's CHECK_FOR_INTERRUPTS)
+void CheckInterruption(ClientContext &context) {
+	if (context.interrupted) {
+		throw InterruptException();
+	}
+}
+
+SleepVectorMode ParseSleepVectorMode(const string &mode) {
+	auto lower = StringUtil::Lower(mode);
+	if (lower == "serial") {
+		return SleepVectorMode::SERIAL;
+	}
+	if (lower == "max") {
+		return SleepVectorMode::MAX;
+	}
+	if (lower == "sum") {
+		return SleepVectorMode::SUM;
+	}
+	if (lower == "per_chunk") {
+		return SleepVectorMode::PER_CHUNK;
+	}
+	throw InvalidInputException("Unrecognized sleep_vector_mode '%s', expected one of: serial, max, sum, per_chunk",
+	                            mode);
+}
+
+SleepVectorMode GetSleepVectorMode(ClientContext &context) {
+	Value mode;
+	if (!context.TryGetCurrentSetting("sleep_vector_mode", mode) || mode.IsNull()) {
+		return SleepVectorMode::SERIAL;
+	}
+	return ParseSleepVectorMode(mode.ToString());
+}
+
+SleepPrecision ParseSleepPrecision(const string &precision) {
+	auto lower = StringUtil::Lower(precision);
+	if (lower == "standard") {
+		return SleepPrecision::STANDARD;
+	}
+	if (lower == "precise") {
+		return SleepPrecision::PRECISE;
+	}
+	throw InvalidInputException("Unrecognized sleep_precision '%s', expected one of: standard, precise", precision);
+}
+
+SleepPrecision GetSleepPrecision(ClientContext &context) {
+	Value precision;
+	if (!context.TryGetCurrentSetting("sleep_precision", precision) || precision.IsNull()) {
+		return SleepPrecision::STANDARD;
+	}
+	return ParseSleepPrecision(precision.ToString());
+}
+
+double ValidateSleepTimeScale(double scale) {
+	if (!std::isfinite(scale) || scale < 0) {
+		throw InvalidInputException("sleep_time_scale must be a finite, non-negative number, got %s",
+		                            std::to_string(scale));
+	}
+	return scale;
+}
+
+double GetSleepTimeScale(ClientContext &context) {
+	Value scale;
+	if (!context.TryGetCurrentSetting("sleep_time_scale", scale) || scale.IsNull()) {
+		return 1.0;
+	}
+	return scale.GetValue<double>();
+}
+
+int64_t ScaleSleepMicros(int64_t micros, double scale) {
+	if (scale == 1.0) {
+		return micros;
+	}
+	auto scaled = static_cast<double>(micros) * scale;
+	if (scaled >= static_cast<double>(MAX_SLEEP_MICROS)) {
+		return MAX_SLEEP_MICROS;
+	}
+	return static_cast<int64_t>(std::llround(scaled));
+}
+
+SleepClock ParseSleepClock(const string &clock) {
+	auto lower = StringUtil::Lower(clock);
+	if (lower == "monotonic") {
+		return SleepClock::MONOTONIC;
+	}
+	if (lower == "realtime") {
+		return SleepClock::REALTIME;
+	}
+	if (lower == "boottime") {
+		return SleepClock::BOOTTIME;
+	}
+	if (lower == "virtual") {
+		return SleepClock::VIRTUAL;
+	}
+	throw InvalidInputException(
+	    "Unrecognized sleep_clock '%s', expected one of: monotonic, realtime, boottime, virtual", clock);
+}
+
+SleepClock GetSleepClock(ClientContext &context) {
+	Value clock;
+	if (!context.TryGetCurrentSetting("sleep_clock", clock) || clock.IsNull()) {
+		return SleepClock::MONOTONIC;
+	}
+	return ParseSleepClock(clock.ToString());
+}
+
+SleepClock GetSleepUntilClock(ClientContext &context) {
+	return GetSleepClock(context) == SleepClock::VIRTUAL ? SleepClock::VIRTUAL : SleepClock::REALTIME;
+}
+
+//===--------------------------------------------------------------------===//
+// Clocks
+//===--------------------------------------------------------------------===//
+
+#ifdef __linux__
+static clockid_t GetClockId(SleepClock clock) {
+	switch (clock) {
+	case SleepClock::REALTIME:
+		return CLOCK_REALTIME;
+	case SleepClock::BOOTTIME:
+		return CLOCK_BOOTTIME;
+	default:
+		return CLOCK_MONOTONIC;
+	}
+}
+#endif
+
+// Reads one of the system clocks in nanoseconds
+static int64_t ReadClock(SleepClock clock) {
+#ifdef __linux__
+	struct timespec now;
+	clock_gettime(GetClockId(clock), &now);
+	return static_cast<int64_t>(now.tv_sec) * NANOS_PER_SECOND + now.tv_nsec;
+#else
+	// Without POSIX clocks boot time falls back to the monotonic clock
+	if (clock == SleepClock::REALTIME) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		           std::chrono::system_clock::now().time_since_epoch())
+		    .count();
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+#endif
+}
+
+// Sleeps until the clock reaches an absolute deadline, used for the final sub-tick part of a sleep
+// clock_nanosleep with TIMER_ABSTIME does not accumulate drift and honours changes of the realtime clock
+static void WaitOnClock(SleepClock clock, int64_t deadline_ns) {
+#ifdef __linux__
+	struct timespec deadline;
+	deadline.tv_sec = static_cast<time_t>(deadline_ns / NANOS_PER_SECOND);
+	deadline.tv_nsec = static_cast<long>(deadline_ns % NANOS_PER_SECOND);
+	while (clock_nanosleep(GetClockId(clock), TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+	}
+#else
+	auto remaining_ns = deadline_ns - ReadClock(clock);
+	if (remaining_ns > 0) {
+		std::this_thread::sleep_for(std::chrono::nanoseconds(remaining_ns));
+	}
+#endif
+}
+
+int64_t SleepClockNow(ClientContext &context, SleepClock clock) {
+	if (clock == SleepClock::VIRTUAL) {
+		return SleepDatabaseState::Get(context).virtual_clock.Now();
+	}
+	return ReadClock(clock);
+}
+
+int64_t SleepClockNow(DatabaseInstance &db, SleepClock clock) {
+	if (clock == SleepClock::VIRTUAL) {
+		return SleepDatabaseState::Get(db).virtual_clock.Now();
+	}
+	return ReadClock(clock);
+}
+
+timestamp_t SleepTimestampNow(ClientContext &context) {
+	return timestamp_t(SleepClockNow(context, GetSleepUntilClock(context)) / NANOS_PER_MICRO);
+}
+
+int64_t TimestampToDeadline(timestamp_t target, int64_t now_ns) {
+	auto now_micros = now_ns / NANOS_PER_MICRO;
+	auto max_micros = now_micros + static_cast<int64_t>(MAX_SLEEP_SECONDS) * Interval::MICROS_PER_SEC;
+	// Targets in the past (including -infinity) are returned as-is, far-future ones (including infinity) are capped
+	if (target.value > max_micros) {
+		return max_micros * NANOS_PER_MICRO;
+	}
+	if (target.value <= now_micros) {
+		return now_micros * NANOS_PER_MICRO;
+	}
+	return target.value * NANOS_PER_MICRO;
+}
+
+//===--------------------------------------------------------------------===//
+// Statistics
+//===--------------------------------------------------------------------===//
+
+// Precise sleeps start spinning this far before the deadline until the first calibration sample arrives
+static constexpr int64_t INITIAL_PRECISE_MARGIN_NS = 200000;
+// Bounds of the calibrated margin: spinning longer than this wastes CPU, shorter cannot absorb wakeup latency
+static constexpr int64_t MIN_PRECISE_MARGIN_NS = 20000;
+static constexpr int64_t MAX_PRECISE_MARGIN_NS = 2000000;
+
+struct SleepEngineCounters {
+	std::atomic<uint64_t> sleeps {0};
+	std::atomic<uint64_t> precise_sleeps {0};
+	std::atomic<uint64_t> overshoot_total_ns {0};
+	std::atomic<uint64_t> overshoot_max_ns {0};
+	std::atomic<uint64_t> precise_overshoot_total_ns {0};
+	std::atomic<uint64_t> precise_overshoot_max_ns {0};
+	std::atomic<uint64_t> spin_total_ns {0};
+	std::atomic<uint64_t> requested_total_us {0};
+	std::atomic<uint64_t> scaled_total_us {0};
+	std::atomic<uint64_t> virtual_sleeps {0};
+	std::atomic<uint64_t> virtual_advanced_us {0};
+	//! Exponentially weighted average of how late the blocking phase of a precise sleep wakes up
+	std::atomic<int64_t> wakeup_latency_ns {INITIAL_PRECISE_MARGIN_NS / 2};
+};
+
+static SleepEngineCounters &GetCounters() {
+	static SleepEngineCounters counters;
+	return counters;
+}
+
+static void UpdateMax(std::atomic<uint64_t> &maximum, uint64_t value) {
+	auto current = maximum.load(std::memory_order_relaxed);
+	while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+static int64_t GetPreciseMargin() {
+	// Twice the average wakeup latency absorbs most outliers without spinning for long
+	auto latency = GetCounters().wakeup_latency_ns.load(std::memory_order_relaxed);
+	return MinValue<int64_t>(MaxValue<int64_t>(latency * 2, MIN_PRECISE_MARGIN_NS), MAX_PRECISE_MARGIN_NS);
+}
+
+static void RecordWakeupLatency(int64_t latency_ns) {
+	auto &average = GetCounters().wakeup_latency_ns;
+	auto current = average.load(std::memory_order_relaxed);
+	// EWMA with a weight of 1/8 per sample; races between threads only drop samples
+	average.store(current + (latency_ns - current) / 8, std::memory_order_relaxed);
+}
+
+static void RecordSleep(SleepPrecision precision, int64_t overshoot_ns, int64_t spin_ns) {
+	auto &counters = GetCounters();
+	auto overshoot = static_cast<uint64_t>(MaxValue<int64_t>(overshoot_ns, 0));
+	counters.sleeps.fetch_add(1, std::memory_order_relaxed);
+	counters.overshoot_total_ns.fetch_add(overshoot, std::memory_order_relaxed);
+	UpdateMax(counters.overshoot_max_ns, overshoot);
+	if (precision == SleepPrecision::PRECISE) {
+		counters.precise_sleeps.fetch_add(1, std::memory_order_relaxed);
+		counters.precise_overshoot_total_ns.fetch_add(overshoot, std::memory_order_relaxed);
+		UpdateMax(counters.precise_overshoot_max_ns, overshoot);
+		counters.spin_total_ns.fetch_add(static_cast<uint64_t>(MaxValue<int64_t>(spin_ns, 0)),
+		                                 std::memory_order_relaxed);
+	}
+}
+
+SleepEngineStatistics GetSleepEngineStatistics() {
+	auto &counters = GetCounters();
+	SleepEngineStatistics result;
+	result.sleeps = counters.sleeps.load();
+	result.precise_sleeps = counters.precise_sleeps.load();
+	result.overshoot_total_ns = counters.overshoot_total_ns.load();
+	result.overshoot_max_ns = counters.overshoot_max_ns.load();
+	result.precise_overshoot_total_ns = counters.precise_overshoot_total_ns.load();
+	result.precise_overshoot_max_ns = counters.precise_overshoot_max_ns.load();
+	result.spin_total_ns = counters.spin_total_ns.load();
+	result.requested_total_us = counters.requested_total_us.load();
+	result.scaled_total_us = counters.scaled_total_us.load();
+	result.precise_margin_ns = static_cast<uint64_t>(GetPreciseMargin());
+	result.virtual_sleeps = counters.virtual_sleeps.load();
+	result.virtual_advanced_us = counters.virtual_advanced_us.load();
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Interruptible Wait
+//===--------------------------------------------------------------------===//
+
+// A single parked sleep: the sleeping thread blocks on its own condition variable until the timer service
+// fires its timer, either because the deadline expired or because the query was interrupted
+class SleepWaiter : public SleepTimer {
+public:
+	explicit SleepWaiter(ClientContext &context) : SleepTimer(context), signalled(false) {
+	}
+
+	void Fire(SleepTimerFireReason reason, vector<InterruptState> &reschedule) override {
+		std::lock_guard<std::mutex> guard(lock);
+		signalled = true;
+		cv.notify_one();
+	}
+
+	// Blocks until the timer fires
+	void Wait() {
+		std::unique_lock<std::mutex> guard(lock);
+		cv.wait(guard, [this]() { return signalled; });
+		signalled = false;
+	}
+
+	// Blocks until the timer fires or the deadline passes, whichever comes first
+	// The timer must be cancelled afterwards, which also discards a signal that raced with the deadline
+	void WaitUntil(SleepTimerService::time_point_t deadline) {
+		std::unique_lock<std::mutex> guard(lock);
+		cv.wait_until(guard, deadline, [this]() { return signalled; });
+	}
+
+	void Reset() {
+		std::lock_guard<std::mutex> guard(lock);
+		signalled = false;
+	}
+
+private:
+	std::mutex lock;
+	std::condition_variable cv;
+	bool signalled;
+};
+
+int64_t ClampSleepMicros(int64_t micros) {
+	// Only sleep for positive durations, capped at the maximum duration for safety
+	return MinValue<int64_t>(MaxValue<int64_t>(micros, 0), MAX_SLEEP_MICROS);
+}
+
+int64_t SecondsToSleepMicros(double seconds) {
+	// Validate input - check for NaN and Infinity BEFORE any other processing
+	if (std::isnan(seconds)) {
+		throw InvalidInputException("Sleep duration cannot be NaN");
+	}
+	if (std::isinf(seconds)) {
+		// For infinity, cap at maximum instead of throwing (more user-friendly)
+		// This prevents accidental infinite sleeps
+		return MAX_SLEEP_MICROS;
+	}
+	if (seconds <= 0) {
+		return 0;
+	}
+	if (seconds >= MAX_SLEEP_SECONDS) {
+		return MAX_SLEEP_MICROS;
+	}
+	// Round to whole nanoseconds first to absorb floating-point noise (0.0015 s is exactly 1500 us), then round up
+	// so a sleep never ends before the requested duration
+	auto nanos = static_cast<int64_t>(std::llround(seconds * static_cast<double>(NANOS_PER_SECOND)));
+	return (nanos + NANOS_PER_MICRO - 1) / NANOS_PER_MICRO;
+}
+
+int64_t IntervalToSleepMicros(const interval_t &interval) {
+	// Note: Months are approximated as 30 days, matching PostgreSQL's behavior for sleep_for
+	// months * MICROS_PER_MONTH alone can overflow int64, so the interval is first normalized to whole days plus a
+	// remainder below one day; these sums cannot overflow
+	int64_t days = static_cast<int64_t>(interval.months) * Interval::DAYS_PER_MONTH + interval.days +
+	               interval.micros / Interval::MICROS_PER_DAY;
+	int64_t micros = interval.micros % Interval::MICROS_PER_DAY;
+	// |micros| < 1 day while the cap is 1 hour, so two or more whole days decide the result on their own
+	if (days >= 2) {
+		return MAX_SLEEP_MICROS;
+	}
+	if (days <= -2) {
+		return 0;
+	}
+	return ClampSleepMicros(days * Interval::MICROS_PER_DAY + micros);
+}
+
+// Lowers the timer slack of the calling thread while a precise sleep blocks, so its blocking phase wakes up on time
+// Linux defaults to 50 us of slack per thread; the previous slack is restored so the worker thread does not keep
+// waking up precisely (and more often) for everything else it runs
+class PreciseTimerSlack {
+public:
+	explicit PreciseTimerSlack(bool enable) {
+#ifdef __linux__
+		if (!enable) {
+			return;
+		}
+		auto slack = prctl(PR_GET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL);
+		if (slack > 1 && prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL) == 0) {
+			previous_slack = slack;
+		}
+#endif
+	}
+	~PreciseTimerSlack() {
+#ifdef __linux__
+		if (previous_slack > 0) {
+			prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(previous_slack), 0UL, 0UL, 0UL);
+		}
+#endif
+	}
+
+private:
+	long previous_slack = 0;
+};
+
+// Tells the CPU we are busy-waiting, reducing power use and freeing resources for a sibling hyperthread
+static inline void SpinPause() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+	_mm_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+// Nothing to wait for on the virtual clock: the sleep is over as soon as it has been moved to its deadline
+static void AdvanceVirtualClock(SleepVirtualClock &virtual_clock, int64_t deadline_ns) {
+	auto advanced_ns = virtual_clock.AdvanceTo(deadline_ns);
+	if (advanced_ns > 0) {
+		auto &counters = GetCounters();
+		counters.virtual_sleeps.fetch_add(1, std::memory_order_relaxed);
+		counters.virtual_advanced_us.fetch_add(static_cast<uint64_t>(advanced_ns / NANOS_PER_MICRO),
+		                                       std::memory_order_relaxed);
+	}
+}
+
+// Core sleep implementation with interruption support
+// Inspired by PostgreSQL's pg_usleep but with DuckDB-specific interrupt handling
+void PerformSleepUntil(ClientContext &context, SleepClock clock, int64_t deadline_ns) {
+	CheckInterruption(context);
+	if (clock == SleepClock::VIRTUAL) {
+		AdvanceVirtualClock(SleepDatabaseState::Get(context).virtual_clock, deadline_ns);
+		return;
+	}
+	if (ReadClock(clock) >= deadline_ns) {
+		return;
+	}
+
+	auto precision = GetSleepPrecision(context);
+	auto block_until_ns = deadline_ns;
+	PreciseTimerSlack timer_slack(precision == SleepPrecision::PRECISE);
+	if (precision == SleepPrecision::PRECISE) {
+		block_until_ns = deadline_ns - GetPreciseMargin();
+	}
+
+	// The timer service parks the thread for the bulk of the sleep, firing within the last tick before the deadline
+	// The sub-tick remainder is waited on the waiter's own deadline so sleeps stay precise despite the wheel's
+	// resolution; the waiter stays armed meanwhile so an interruption still wakes it
+	auto &service = SleepTimerService::Get();
+	auto tick_ns = SleepTimerService::TICK_MICROS * NANOS_PER_MICRO;
+	SleepWaiter waiter(context);
+	while (true) {
+		CheckInterruption(context);
+		auto remaining_ns = block_until_ns - ReadClock(clock);
+		if (remaining_ns <= 0) {
+			break;
+		}
+		if (remaining_ns <= tick_ns) {
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(remaining_ns);
+			service.Arm(waiter, deadline);
+			waiter.WaitUntil(deadline);
+			service.Cancel(waiter);
+			waiter.Reset();
+			continue;
+		}
+		// The wheel runs on the monotonic clock; the other clocks can jump or keep running during suspend,
+		// so their deadlines are re-evaluated at least every CLOCK_RECHECK_NS
+		auto park_ns = remaining_ns - tick_ns;
+		if (clock != SleepClock::MONOTONIC) {
+			park_ns = MinValue<int64_t>(park_ns, CLOCK_RECHECK_NS);
+		}
+		service.Arm(waiter, std::chrono::steady_clock::now() + std::chrono::nanoseconds(park_ns));
+		waiter.Wait();
+	}
+
+	int64_t spin_ns = 0;
+	if (precision == SleepPrecision::PRECISE) {
+		// Calibrate the margin with how late the blocking phase woke up, then spin through the rest
+		auto remaining_ns = deadline_ns - ReadClock(clock);
+		RecordWakeupLatency(deadline_ns - block_until_ns - remaining_ns);
+		// The spin always runs on the monotonic clock: the other clocks are slower to read and can be stepped
+		// while spinning, which would either cut the spin short or keep the thread spinning
+		auto spin_start_ns = ReadClock(SleepClock::MONOTONIC);
+		auto spin_until_ns = spin_start_ns + remaining_ns;
+		while (ReadClock(SleepClock::MONOTONIC) < spin_until_ns) {
+			CheckInterruption(context);
+			SpinPause();
+		}
+		spin_ns = ReadClock(SleepClock::MONOTONIC) - spin_start_ns;
+	}
+	RecordSleep(precision, ReadClock(clock) - deadline_ns, spin_ns);
+}
+
+void PerformSleepUntil(DatabaseInstance &db, SleepClock clock, int64_t deadline_ns) {
+	if (clock == SleepClock::VIRTUAL) {
+		AdvanceVirtualClock(SleepDatabaseState::Get(db).virtual_clock, deadline_ns);
+		return;
+	}
+	if (ReadClock(clock) >= deadline_ns) {
+		return;
+	}
+	while (ReadClock(clock) < deadline_ns) {
+		WaitOnClock(clock, deadline_ns);
+	}
+	RecordSleep(SleepPrecision::STANDARD, ReadClock(clock) - deadline_ns, 0);
+}
+
+// Sleeps for a duration that already has the time scale applied
+static void SleepForScaled(ClientContext &context, int64_t micros) {
+	if (micros == 0) {
+		return;
+	}
+	auto clock = GetSleepClock(context);
+	PerformSleepUntil(context, clock, SleepClockNow(context, clock) + micros * NANOS_PER_MICRO);
+}
+
+void PerformSleep(ClientContext &context, int64_t micros) {
+	micros = ClampSleepMicros(micros);
+	if (micros == 0) {
+		return;
+	}
+	auto scaled = ScaleSleepMicros(micros, GetSleepTimeScale(context));
+	auto &counters = GetCounters();
+	counters.requested_total_us.fetch_add(static_cast<uint64_t>(micros), std::memory_order_relaxed);
+	counters.scaled_total_us.fetch_add(static_cast<uint64_t>(scaled), std::memory_order_relaxed);
+	SleepForScaled(context, scaled);
+}
+
+//===--------------------------------------------------------------------===//
+// Chunk Sleep
+//===--------------------------------------------------------------------===//
+
+ChunkSleep::ChunkSleep(ClientContext &context, SleepVectorMode mode)
+    : context(context), mode(mode), until_clock(GetSleepUntilClock(context)), time_scale(GetSleepTimeScale(context)) {
+	// The virtual clock has no meaningful query start, so its targets are never scaled
+	if (time_scale != 1.0 && until_clock == SleepClock::REALTIME) {
+		scale_targets = true;
+		origin_micros = MetaTransaction::Get(context).start_timestamp.value;
+	}
+}
+
+// Converts a scaled target back to a timestamp, saturating at the infinities
+static timestamp_t ScaledTimestamp(double micros) {
+	auto limit = NumericLimits<int64_t>::Maximum();
+	if (micros >= static_cast<double>(limit)) {
+		return timestamp_t(limit);
+	}
+	if (micros <= -static_cast<double>(limit)) {
+		return timestamp_t(-limit);
+	}
+	return timestamp_t(static_cast<int64_t>(std::llround(micros)));
+}
+
+int64_t ChunkSleep::TargetToDeadline(timestamp_t target, int64_t now_ns) const {
+	if (!scale_targets) {
+		return TimestampToDeadline(target, now_ns);
+	}
+	// Stretch or compress the distance from the start of the query; computed in doubles so the infinities and
+	// targets far in the past cannot overflow
+	auto origin = static_cast<double>(origin_micros);
+	auto scaled = origin + (static_cast<double>(target.value) - origin) * time_scale;
+	return TimestampToDeadline(ScaledTimestamp(scaled), now_ns);
+}
+
+int64_t ChunkSleep::PendingThreshold(int64_t now_ns) const {
+	auto now_micros = now_ns / NANOS_PER_MICRO;
+	if (!scale_targets) {
+		return now_micros;
+	}
+	if (time_scale == 0) {
+		// Every target collapses onto the query start, which has passed
+		return NumericLimits<int64_t>::Maximum();
+	}
+	// The unscaled target that maps onto now; rounding down only lets a few targets through that turn out not to wait
+	auto origin = static_cast<double>(origin_micros);
+	auto threshold = origin + (static_cast<double>(now_micros) - origin) / time_scale;
+	return ScaledTimestamp(std::floor(threshold)).value;
+}
+
+void ChunkSleep::Add(int64_t micros) {
+	micros = ClampSleepMicros(micros);
+	switch (mode) {
+	case SleepVectorMode::SERIAL:
+		PerformSleep(context, micros);
+		break;
+	case SleepVectorMode::MAX:
+		total = MaxValue<int64_t>(total, micros);
+		break;
+	case SleepVectorMode::SUM:
+		// Both operands are at most MAX_SLEEP_MICROS, so the sum cannot overflow before clamping
+		total = ClampSleepMicros(total + micros);
+		break;
+	case SleepVectorMode::PER_CHUNK:
+		if (!has_value) {
+			total = micros;
+		}
+		break;
+	}
+	has_value = true;
+}
+
+void ChunkSleep::AddConstant(int64_t micros, idx_t count) {
+	micros = ClampSleepMicros(micros);
+	if (micros == 0 || count == 0) {
+		// Nothing to wait for, skip the per-row work entirely
+		has_value = true;
+		return;
+	}
+	switch (mode) {
+	case SleepVectorMode::SERIAL:
+		for (idx_t i = 0; i < count; i++) {
+			PerformSleep(context, micros);
+		}
+		break;
+	case SleepVectorMode::MAX:
+		total = MaxValue<int64_t>(total, micros);
+		break;
+	case SleepVectorMode::SUM:
+		// Saturate instead of multiplying: MAX_SLEEP_MICROS * count could overflow for large chunks
+		if (micros > (MAX_SLEEP_MICROS - total) / static_cast<int64_t>(count)) {
+			total = MAX_SLEEP_MICROS;
+		} else {
+			total += micros * static_cast<int64_t>(count);
+		}
+		break;
+	case SleepVectorMode::PER_CHUNK:
+		if (!has_value) {
+			total = micros;
+		}
+		break;
+	}
+	has_value = true;
+}
+
+void ChunkSleep::AddDeadline(int64_t deadline_ns) {
+	switch (mode) {
+	case SleepVectorMode::SERIAL:
+		PerformSleepUntil(context, until_clock, deadline_ns);
+		break;
+	case SleepVectorMode::MAX:
+		deadline = has_value ? MaxValue<int64_t>(deadline, deadline_ns) : deadline_ns;
+		has_deadline = true;
+		break;
+	case SleepVectorMode::SUM: {
+		// Summing absolute targets only makes sense for the time that remains until each of them
+		auto remaining_ns = deadline_ns - UntilNow();
+		total = ClampSleepMicros(total + ClampSleepMicros(remaining_ns / NANOS_PER_MICRO));
+		total_scaled = true;
+		break;
+	}
+	case SleepVectorMode::PER_CHUNK:
+		if (!has_value) {
+			deadline = deadline_ns;
+			has_deadline = true;
+		}
+		break;
+	}
+	has_value = true;
+}
+
+void ChunkSleep::Finish() {
+	if (mode == SleepVectorMode::SERIAL || !has_value) {
+		return;
+	}
+	if (has_deadline) {
+		PerformSleepUntil(context, until_clock, deadline);
+	} else if (total_scaled) {
+		SleepForScaled(context, total);
+	} else {
+		PerformSleep(context, total);
+	}
+}
+
+} // namespace duckdb
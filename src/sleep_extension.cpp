@@ -1,196 +1,524 @@
 #define DUCKDB_EXTENSION_MAIN
 
 #include "sleep_extension.hpp"
+#include "sleep_async.hpp"
+#include "sleep_duty_cycle.hpp"
+#include "sleep_engine.hpp"
+#include "sleep_fs.hpp"
+#include "sleep_random.hpp"
+#include "sleep_replay.hpp"
+#include "sleep_state.hpp"
+#include "sleep_throttle.hpp"
+#include "sleep_timer_service.hpp"
 
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/function/scalar_function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
 #include "duckdb/main/extension/extension_loader.hpp"
 #include "duckdb/parser/parsed_data/create_scalar_function_info.hpp"
+#include "duckdb/planner/expression.hpp"
 
-#include <thread>
-#include <chrono>
-#include <algorithm>
 #include <cmath>
-#include <limits>
 
 namespace duckdb {
 
 //===--------------------------------------------------------------------===//
-// Constants
+// Function Implementations
 //===--------------------------------------------------------------------===//
 
-// Maximum sleep duration in seconds (1 hour) to prevent accidental infinite waits
-static constexpr double MAX_SLEEP_SECONDS = 3600.0;
-
-// Interruption check interval in milliseconds
-// Similar to PostgreSQL's approach of checking for interrupts periodically
-static constexpr int64_t CHECK_INTERVAL_MS = 100;
+// Converts the input values of the relative sleep functions to clamped durations in microseconds
+struct SleepSecondsOperator {
+	static bool IsNaN(double seconds) {
+		return seconds != seconds;
+	}
 
-//===--------------------------------------------------------------------===//
-// Helper Functions
-//===--------------------------------------------------------------------===//
+	static int64_t ToMicros(double seconds) {
+		return SecondsToSleepMicros(seconds);
+	}
+};
 
-// Check for query cancellation (similar to PostgreSQL's CHECK_FOR_INTERRUPTS)
-static void CheckInterruption(ClientContext &context) {
-	if (context.interrupted) {
-		throw InterruptException();
+struct SleepIntervalOperator {
+	static bool IsNaN(const interval_t &interval) {
+		return false;
 	}
-}
 
-// Core sleep implementation with interruption support
-// Inspired by PostgreSQL's pg_usleep but with DuckDB-specific interrupt handling
-static void PerformSleep(ClientContext &context, double seconds) {
-	// Validate input - check for NaN and Infinity BEFORE any other processing
-	if (std::isnan(seconds)) {
-		throw InvalidInputException("Sleep duration cannot be NaN");
+	static int64_t ToMicros(const interval_t &interval) {
+		return IntervalToSleepMicros(interval);
 	}
-	if (std::isinf(seconds)) {
-		// For infinity, cap at maximum instead of throwing (more user-friendly)
-		// This prevents accidental infinite sleeps
-		seconds = MAX_SLEEP_SECONDS;
+};
+
+// Pre-pass over a chunk: converts every row to a duration in microseconds (zero for NULL) and reports NaN in bulk
+// Flat vectors without NULLs take a contiguous loop the compiler can vectorize
+template <class T, class OP>
+static void ConvertDurations(const UnifiedVectorFormat &vdata, idx_t count, int64_t *durations, bool &has_nan) {
+	auto data = UnifiedVectorFormat::GetData<T>(vdata);
+	bool nan_found = false;
+	if (!vdata.sel->IsSet() && vdata.validity.AllValid()) {
+		for (idx_t i = 0; i < count; i++) {
+			bool is_nan = OP::IsNaN(data[i]);
+			nan_found |= is_nan;
+			durations[i] = is_nan ? 0 : OP::ToMicros(data[i]);
+		}
+	} else {
+		for (idx_t i = 0; i < count; i++) {
+			auto idx = vdata.sel->get_index(i);
+			bool valid = vdata.validity.RowIsValid(idx);
+			bool is_nan = valid && OP::IsNaN(data[idx]);
+			nan_found |= is_nan;
+			durations[i] = valid && !is_nan ? OP::ToMicros(data[idx]) : 0;
+		}
 	}
+	has_nan = nan_found;
+}
 
-	// Only sleep for positive durations
-	if (seconds <= 0) {
-		return;
+// Collects the rows that need a real wait into pending_sel with a branch-free compaction
+// Rows that do not wait never reach the sleep engine and therefore never read the clock
+static idx_t SelectPendingDurations(const int64_t *durations, idx_t count, SelectionVector &pending_sel) {
+	idx_t pending_count = 0;
+	for (idx_t i = 0; i < count; i++) {
+		pending_sel.set_index(pending_count, i);
+		pending_count += durations[i] > 0;
 	}
+	return pending_count;
+}
 
-	// Cap at maximum duration for safety (in case value was very large but not infinity)
-	if (seconds > MAX_SLEEP_SECONDS) {
-		seconds = MAX_SLEEP_SECONDS;
+// Returns the first non-NULL row of the chunk, or count if there is none
+// In per_chunk mode that row alone decides the wait, even when it does not need one, so the pre-pass must not skip it
+static idx_t FirstValidRow(const UnifiedVectorFormat &vdata, idx_t count) {
+	if (vdata.validity.AllValid()) {
+		return 0;
 	}
+	for (idx_t i = 0; i < count; i++) {
+		if (vdata.validity.RowIsValid(vdata.sel->get_index(i))) {
+			return i;
+		}
+	}
+	return count;
+}
 
-	auto duration = std::chrono::duration<double>(seconds);
-	auto end_time = std::chrono::steady_clock::now() + duration;
-
-	// Sleep in small intervals to allow interruption
-	// PostgreSQL uses nanosleep which can be interrupted by signals
-	// We simulate this by checking context.interrupted periodically
-	while (std::chrono::steady_clock::now() < end_time) {
-		CheckInterruption(context);
-
-		auto remaining = end_time - std::chrono::steady_clock::now();
-		auto check_interval = std::chrono::milliseconds(CHECK_INTERVAL_MS);
-		auto sleep_duration = (remaining < check_interval) ? remaining : check_interval;
-
-		if (sleep_duration.count() > 0) {
-			std::this_thread::sleep_for(sleep_duration);
+// Kernel of the relative sleep functions
+// Constant inputs are validated and converted once per chunk; other vectors are read through UnifiedVectorFormat so
+// dictionary and sequence vectors are never flattened, and a pre-pass skips the rows that do not need to wait
+template <class T, class OP>
+static void SleepForDurations(ClientContext &context, Vector &input, idx_t count) {
+	auto mode = GetSleepVectorMode(context);
+	ChunkSleep chunk_sleep(context, mode);
+	if (input.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+		if (!ConstantVector::IsNull(input)) {
+			chunk_sleep.AddConstant(OP::ToMicros(*ConstantVector::GetData<T>(input)), count);
+		}
+	} else {
+		UnifiedVectorFormat vdata;
+		input.ToUnifiedFormat(count, vdata);
+		int64_t durations[STANDARD_VECTOR_SIZE];
+		bool has_nan;
+		ConvertDurations<T, OP>(vdata, count, durations, has_nan);
+		if (has_nan) {
+			throw InvalidInputException("Sleep duration cannot be NaN");
+		}
+		if (mode == SleepVectorMode::PER_CHUNK) {
+			auto first = FirstValidRow(vdata, count);
+			if (first < count) {
+				chunk_sleep.Add(durations[first]);
+			}
+		} else {
+			SelectionVector pending_sel(count);
+			auto pending_count = SelectPendingDurations(durations, count, pending_sel);
+			for (idx_t i = 0; i < pending_count; i++) {
+				chunk_sleep.Add(durations[pending_sel.get_index(i)]);
+			}
 		}
 	}
+	chunk_sleep.Finish();
 }
 
-//===--------------------------------------------------------------------===//
-// Function Implementations
-//===--------------------------------------------------------------------===//
+template <class T, class OP>
+static void ExecuteSleep(DataChunk &args, ExpressionState &state, Vector &result) {
+	SleepForDurations<T, OP>(state.GetContext(), args.data[0], args.size());
 
-// sleep(seconds)
-// Compatible with PostgreSQL 8.2+
-// Delays execution for at least the specified number of seconds
-static void SleepFunction(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &context = state.GetContext();
-	auto &seconds_vector = args.data[0];
-	seconds_vector.Flatten(args.size());
+	// Return NULL (void function, PostgreSQL-compatible)
+	result.SetVectorType(VectorType::CONSTANT_VECTOR);
+	ConstantVector::SetNull(result, true);
+}
 
-	auto seconds_data = FlatVector::GetData<double>(seconds_vector);
-	auto &validity = FlatVector::Validity(seconds_vector);
+// Kernel of delay: sleeps for the durations in the second column, then hands the first column through untouched
+// The result references the input vector, so no value is copied whatever its type
+template <class T, class OP>
+static void ExecuteDelay(DataChunk &args, ExpressionState &state, Vector &result) {
+	SleepForDurations<T, OP>(state.GetContext(), args.data[1], args.size());
+	result.Reference(args.data[0]);
+}
 
-	for (idx_t i = 0; i < args.size(); i++) {
-		if (!validity.RowIsValid(i)) {
-			continue; // Skip NULL values
+// Kernel of sleep_until: rows sleep towards absolute wall-clock deadlines rather than relative durations, so the
+// wait is drift-free and follows changes of the system clock (or of the virtual clock when it is selected)
+static void ExecuteSleepUntil(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto &input = args.data[0];
+	auto count = args.size();
+
+	auto mode = GetSleepVectorMode(context);
+	ChunkSleep chunk_sleep(context, mode);
+	if (input.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+		// Once the first row reached the target the remaining rows find it in the past
+		if (!ConstantVector::IsNull(input)) {
+			auto target = *ConstantVector::GetData<timestamp_t>(input);
+			chunk_sleep.AddDeadline(chunk_sleep.TargetToDeadline(target, chunk_sleep.UntilNow()));
+		}
+	} else {
+		UnifiedVectorFormat vdata;
+		input.ToUnifiedFormat(count, vdata);
+		auto data = UnifiedVectorFormat::GetData<timestamp_t>(vdata);
+		if (mode == SleepVectorMode::PER_CHUNK) {
+			auto first = FirstValidRow(vdata, count);
+			if (first < count) {
+				auto target = data[vdata.sel->get_index(first)];
+				chunk_sleep.AddDeadline(chunk_sleep.TargetToDeadline(target, chunk_sleep.UntilNow()));
+			}
+		} else {
+			// Targets at or before the start of the chunk stay in the past (including -infinity), so one clock read
+			// per chunk filters them out
+			auto now_ns = chunk_sleep.UntilNow();
+			auto threshold = chunk_sleep.PendingThreshold(now_ns);
+			SelectionVector pending_sel(count);
+			idx_t pending_count = 0;
+			for (idx_t i = 0; i < count; i++) {
+				auto idx = vdata.sel->get_index(i);
+				pending_sel.set_index(pending_count, idx);
+				pending_count += vdata.validity.RowIsValid(idx) && data[idx].value > threshold;
+			}
+			for (idx_t i = 0; i < pending_count; i++) {
+				chunk_sleep.AddDeadline(chunk_sleep.TargetToDeadline(data[pending_sel.get_index(i)], now_ns));
+			}
 		}
-
-		PerformSleep(context, seconds_data[i]);
 	}
+	chunk_sleep.Finish();
 
 	// Return NULL (void function, PostgreSQL-compatible)
 	result.SetVectorType(VectorType::CONSTANT_VECTOR);
 	ConstantVector::SetNull(result, true);
 }
 
+// sleep(seconds)
+// Compatible with PostgreSQL 8.2+
+// Delays execution for at least the specified number of seconds
+static void SleepFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	ExecuteSleep<double, SleepSecondsOperator>(args, state, result);
+}
+
 // sleep_for(interval)
 // Compatible with PostgreSQL 9.6+
 // Delays execution for at least the specified interval
+// Note: Months are approximated as 30 days, matching PostgreSQL's behavior
 static void SleepForFunction(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &context = state.GetContext();
-	auto &interval_vector = args.data[0];
-	interval_vector.Flatten(args.size());
-
-	auto interval_data = FlatVector::GetData<interval_t>(interval_vector);
-	auto &validity = FlatVector::Validity(interval_vector);
-
-	for (idx_t i = 0; i < args.size(); i++) {
-		if (!validity.RowIsValid(i)) {
-			continue; // Skip NULL values
-		}
-
-		interval_t interval = interval_data[i];
+	ExecuteSleep<interval_t, SleepIntervalOperator>(args, state, result);
+}
 
-		// Convert interval to seconds
-		// Note: Months are approximated as 30 days (2,592,000 seconds)
-		// This matches PostgreSQL's behavior for sleep_for
-		double total_seconds = static_cast<double>(interval.days) * 86400.0 +     // days to seconds
-		                       static_cast<double>(interval.months) * 2592000.0 + // months to seconds
-		                       static_cast<double>(interval.micros) / 1000000.0;  // microseconds to seconds
+// delay(value, seconds | interval)
+// Returns value unchanged after sleeping like sleep or sleep_for, injecting latency without an extra column
+static void DelaySecondsFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	ExecuteDelay<double, SleepSecondsOperator>(args, state, result);
+}
 
-		PerformSleep(context, total_seconds);
-	}
+static void DelayIntervalFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	ExecuteDelay<interval_t, SleepIntervalOperator>(args, state, result);
+}
 
-	// Return NULL (void function, PostgreSQL-compatible)
-	result.SetVectorType(VectorType::CONSTANT_VECTOR);
-	ConstantVector::SetNull(result, true);
+static unique_ptr<FunctionData> DelayBind(ClientContext &context, ScalarFunction &bound_function,
+                                          vector<unique_ptr<Expression>> &arguments) {
+	// The result has the type of the value that is passed through
+	bound_function.arguments[0] = arguments[0]->return_type;
+	bound_function.return_type = arguments[0]->return_type;
+	return nullptr;
 }
 
 // sleep_until(timestamp)
 // Compatible with PostgreSQL 9.6+
 // Delays execution until at least the specified timestamp
 static void SleepUntilFunction(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto &context = state.GetContext();
-	auto &timestamp_vector = args.data[0];
-	timestamp_vector.Flatten(args.size());
+	ExecuteSleepUntil(args, state, result);
+}
 
-	auto timestamp_data = FlatVector::GetData<timestamp_t>(timestamp_vector);
-	auto &validity = FlatVector::Validity(timestamp_vector);
+// sleep_now()
+// Returns the time that sleep_until targets are resolved against: the virtual clock when sleep_clock is 'virtual',
+// the wall clock otherwise
+static void SleepNowFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	result.SetVectorType(VectorType::CONSTANT_VECTOR);
+	*ConstantVector::GetData<timestamp_t>(result) = SleepTimestampNow(state.GetContext());
+}
 
-	for (idx_t i = 0; i < args.size(); i++) {
-		if (!validity.RowIsValid(i)) {
-			continue; // Skip NULL values
-		}
+//===--------------------------------------------------------------------===//
+// Statistics
+//===--------------------------------------------------------------------===//
+
+struct SleepStatsEntry {
+	string component;
+	string name;
+	int64_t value;
+};
+
+struct SleepStatsState : public GlobalTableFunctionState {
+	vector<SleepStatsEntry> entries;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SleepStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                               vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("component");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("name");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("value");
+	return_types.emplace_back(LogicalType::BIGINT);
+	return nullptr;
+}
 
-		timestamp_t target_timestamp = timestamp_data[i];
+static unique_ptr<GlobalTableFunctionState> SleepStatsInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto result = make_uniq<SleepStatsState>();
+	auto timer_stats = SleepTimerService::Get().GetStatistics();
+	auto &entries = result->entries;
+	entries.push_back({"timer", "armed", NumericCast<int64_t>(timer_stats.armed)});
+	entries.push_back({"timer", "total_armed", NumericCast<int64_t>(timer_stats.total_armed)});
+	entries.push_back({"timer", "expired", NumericCast<int64_t>(timer_stats.expired)});
+	entries.push_back({"timer", "interrupted", NumericCast<int64_t>(timer_stats.interrupted)});
+	entries.push_back({"timer", "cancelled", NumericCast<int64_t>(timer_stats.cancelled)});
+	entries.push_back({"timer", "cascaded", NumericCast<int64_t>(timer_stats.cascaded)});
+	entries.push_back({"timer", "ticks", NumericCast<int64_t>(timer_stats.ticks)});
+	entries.push_back({"timer", "wakeups", NumericCast<int64_t>(timer_stats.wakeups)});
+	entries.push_back({"timer", "watched_contexts", NumericCast<int64_t>(timer_stats.watched_contexts)});
+	auto engine_stats = GetSleepEngineStatistics();
+	entries.push_back({"engine", "sleeps", NumericCast<int64_t>(engine_stats.sleeps)});
+	entries.push_back({"engine", "requested_total_us", NumericCast<int64_t>(engine_stats.requested_total_us)});
+	entries.push_back({"engine", "scaled_total_us", NumericCast<int64_t>(engine_stats.scaled_total_us)});
+	entries.push_back({"engine", "overshoot_total_ns", NumericCast<int64_t>(engine_stats.overshoot_total_ns)});
+	entries.push_back({"engine", "overshoot_max_ns", NumericCast<int64_t>(engine_stats.overshoot_max_ns)});
+	entries.push_back({"precise", "sleeps", NumericCast<int64_t>(engine_stats.precise_sleeps)});
+	entries.push_back(
+	    {"precise", "overshoot_total_ns", NumericCast<int64_t>(engine_stats.precise_overshoot_total_ns)});
+	entries.push_back({"precise", "overshoot_max_ns", NumericCast<int64_t>(engine_stats.precise_overshoot_max_ns)});
+	entries.push_back({"precise", "spin_total_ns", NumericCast<int64_t>(engine_stats.spin_total_ns)});
+	entries.push_back({"precise", "margin_ns", NumericCast<int64_t>(engine_stats.precise_margin_ns)});
+	auto throttle_stats = GetSleepThrottleStatistics();
+	entries.push_back({"throttle", "tokens", NumericCast<int64_t>(throttle_stats.tokens)});
+	entries.push_back({"throttle", "waits", NumericCast<int64_t>(throttle_stats.waits)});
+	entries.push_back({"throttle", "wait_total_us", NumericCast<int64_t>(throttle_stats.wait_total_us)});
+	entries.push_back({"throttle", "buckets_expired", NumericCast<int64_t>(throttle_stats.buckets_expired)});
+	// The keyed buckets belong to the database, all other counters are process-wide
+	entries.push_back(
+	    {"throttle", "buckets", NumericCast<int64_t>(SleepDatabaseState::Get(context).throttle_buckets.Size())});
+	entries.push_back({"virtual", "sleeps", NumericCast<int64_t>(engine_stats.virtual_sleeps)});
+	entries.push_back({"virtual", "advanced_us", NumericCast<int64_t>(engine_stats.virtual_advanced_us)});
+	auto fs_stats = GetSleepFileSystemStatistics();
+	entries.push_back({"fs", "reads", NumericCast<int64_t>(fs_stats.reads)});
+	entries.push_back({"fs", "writes", NumericCast<int64_t>(fs_stats.writes)});
+	entries.push_back({"fs", "syncs", NumericCast<int64_t>(fs_stats.syncs)});
+	entries.push_back({"fs", "seeks", NumericCast<int64_t>(fs_stats.seeks)});
+	entries.push_back({"fs", "bytes_read", NumericCast<int64_t>(fs_stats.bytes_read)});
+	entries.push_back({"fs", "bytes_written", NumericCast<int64_t>(fs_stats.bytes_written)});
+	entries.push_back({"fs", "wait_total_us", NumericCast<int64_t>(fs_stats.wait_total_us)});
+	entries.push_back({"fs", "requests", NumericCast<int64_t>(fs_stats.requests)});
+	entries.push_back({"fs", "queued_total_us", NumericCast<int64_t>(fs_stats.queued_total_us)});
+	entries.push_back({"fs", "first_byte_total_us", NumericCast<int64_t>(fs_stats.first_byte_total_us)});
+	entries.push_back({"fs", "write_throttles", NumericCast<int64_t>(fs_stats.write_throttles)});
+	entries.push_back({"fs", "write_throttled_total_us", NumericCast<int64_t>(fs_stats.write_throttled_total_us)});
+	entries.push_back({"fs", "read_throttles", NumericCast<int64_t>(fs_stats.read_throttles)});
+	entries.push_back({"fs", "read_throttled_total_us", NumericCast<int64_t>(fs_stats.read_throttled_total_us)});
+	auto cpu_stats = GetSleepDutyCycleStatistics();
+	entries.push_back({"cpu", "busy_total_us", NumericCast<int64_t>(cpu_stats.busy_total_us)});
+	entries.push_back({"cpu", "throttled_total_us", NumericCast<int64_t>(cpu_stats.throttled_total_us)});
+	return std::move(result);
+}
 
-		// Get current timestamp in microseconds (DuckDB's internal representation)
-		auto current_timestamp = Timestamp::GetCurrentTimestamp();
+// sleep_stats()
+// Reports the counters of the extension's sleep machinery, one row per counter
+static void SleepStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<SleepStatsState>();
+	idx_t count = 0;
+	while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &entry = state.entries[state.offset++];
+		output.SetValue(0, count, Value(entry.component));
+		output.SetValue(1, count, Value(entry.name));
+		output.SetValue(2, count, Value::BIGINT(entry.value));
+		count++;
+	}
+	output.SetCardinality(count);
+}
 
-		// Handle infinite timestamps to prevent overflow/underflow
-		if (target_timestamp.value == std::numeric_limits<int64_t>::min()) {
-			continue; // -infinity: return immediately
+//===--------------------------------------------------------------------===//
+// Extension Registration
+//===--------------------------------------------------------------------===//
+
+static void SetSleepVectorMode(ClientContext &context, SetScope scope, Value &parameter) {
+	// Validate eagerly so a typo is reported by SET rather than by the next sleep
+	ParseSleepVectorMode(parameter.ToString());
+}
+
+static void SetSleepPrecision(ClientContext &context, SetScope scope, Value &parameter) {
+	ParseSleepPrecision(parameter.ToString());
+}
+
+static void SetSleepClock(ClientContext &context, SetScope scope, Value &parameter) {
+	ParseSleepClock(parameter.ToString());
+}
+
+static void SetSleepTimeScale(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		ValidateSleepTimeScale(parameter.GetValue<double>());
+	}
+}
+
+static void SetSleepFsLatency(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto latency = parameter.GetValue<double>();
+		if (!std::isfinite(latency) || latency < 0) {
+			throw InvalidInputException("sleep_fs_latency must be a finite, non-negative number");
 		}
-		if (target_timestamp.value == std::numeric_limits<int64_t>::max()) {
-			PerformSleep(context, MAX_SLEEP_SECONDS);
-			continue;
+	}
+}
+
+static void SetSleepFsSeekLatency(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto latency = parameter.GetValue<double>();
+		if (!std::isfinite(latency) || latency < 0) {
+			throw InvalidInputException("sleep_fs_seek_latency must be a finite, non-negative number");
 		}
+	}
+}
 
-		// Calculate time difference in microseconds
-		int64_t diff_micros = target_timestamp.value - current_timestamp.value;
+static void SetSleepFsBandwidth(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto bandwidth = parameter.GetValue<double>();
+		if (!std::isfinite(bandwidth) || bandwidth < 0) {
+			throw InvalidInputException("bandwidth must be a finite, non-negative number");
+		}
+	}
+}
 
-		// Convert microseconds to seconds (similar to PostgreSQL's conversion)
-		double seconds = static_cast<double>(diff_micros) / 1000000.0;
+static void SetSleepFsWriteBurst(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto burst = parameter.GetValue<double>();
+		if (!std::isfinite(burst) || burst < 0) {
+			throw InvalidInputException("sleep_fs_write_burst must be a finite, non-negative number");
+		}
+	}
+}
 
-		PerformSleep(context, seconds);
+static void SetSleepFsReadWeight(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto weight = parameter.GetValue<double>();
+		if (!std::isfinite(weight) || weight <= 0) {
+			throw InvalidInputException("sleep_fs_read_weight must be a positive, finite number");
+		}
 	}
+}
 
-	// Return NULL (void function, PostgreSQL-compatible)
-	result.SetVectorType(VectorType::CONSTANT_VECTOR);
-	ConstantVector::SetNull(result, true);
+static void SetSleepFsReadBurst(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto burst = parameter.GetValue<double>();
+		if (!std::isfinite(burst) || burst < 0) {
+			throw InvalidInputException("sleep_fs_read_burst must be a finite, non-negative number");
+		}
+	}
 }
 
-//===--------------------------------------------------------------------===//
-// Extension Registration
-//===--------------------------------------------------------------------===//
+static void SetCpuDutyCycle(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		auto duty_cycle = parameter.GetValue<double>();
+		if (!(duty_cycle > 0 && duty_cycle <= 1)) {
+			throw InvalidInputException("cpu_duty_cycle must be greater than 0 and at most 1");
+		}
+	}
+}
+
+static void SetSleepFsFirstByteLatency(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull() && !parameter.ToString().empty()) {
+		ParseSleepDistributionSpec("sleep_fs_first_byte_latency", parameter.ToString());
+	}
+}
 
 static void LoadInternal(ExtensionLoader &loader) {
+	// All sleeps share one timer service that owns their deadlines
+	SleepTimerService::Get().Start();
+
+	// Register settings
+	auto &config = DBConfig::GetConfig(loader.GetDatabaseInstance());
+	config.AddExtensionOption("sleep_vector_mode",
+	                          "How sleep functions handle a chunk of rows: 'serial' sleeps for every row in turn, "
+	                          "'max' and 'sum' sleep once for the longest or total duration, 'per_chunk' sleeps once "
+	                          "for the first row's duration",
+	                          LogicalType::VARCHAR, Value("serial"), SetSleepVectorMode);
+	config.AddExtensionOption("sleep_clock",
+	                          "Clock that relative sleeps measure their deadline on: 'monotonic', 'realtime', "
+	                          "'boottime' or 'virtual', a simulated per-database clock that sleeps advance without "
+	                          "blocking (sleep_until and sleep_now() follow the virtual clock, otherwise the wall clock)",
+	                          LogicalType::VARCHAR, Value("monotonic"), SetSleepClock);
+	config.AddExtensionOption("sleep_precision",
+	                          "How closely sleeps track their deadline: 'standard' blocks until the deadline, 'precise' "
+	                          "blocks until a calibrated margin before it and spins for the rest",
+	                          LogicalType::VARCHAR, Value("standard"), SetSleepPrecision);
+	config.AddExtensionOption("sleep_time_scale",
+	                          "Factor that sleep durations are multiplied with, e.g. 0.01 to replay delays 100x faster; "
+	                          "sleep_until targets are scaled relative to the start of the query",
+	                          LogicalType::DOUBLE, Value::DOUBLE(1.0), SetSleepTimeScale);
+	config.AddExtensionOption("sleep_fs_latency",
+	                          "Seconds added to every read, write and sync of a slowfs:// file", LogicalType::DOUBLE,
+	                          Value::DOUBLE(0), SetSleepFsLatency);
+	config.AddExtensionOption("sleep_fs_seek_latency",
+	                          "Seconds added when a slowfs:// file is accessed anywhere but where the previous access "
+	                          "ended",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsSeekLatency);
+	config.AddExtensionOption("sleep_fs_bandwidth",
+	                          "Transfer rate of slowfs:// files in bytes per second, shared by all files of the "
+	                          "database; 0 for unlimited",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsBandwidth);
+	config.AddExtensionOption("sleep_fs_first_byte_latency",
+	                          "Distribution of the time to the first byte of each slowfs:// request in seconds, e.g. "
+	                          "'lognormal(-3.5, 0.5)'; added to sleep_fs_latency, empty to disable",
+	                          LogicalType::VARCHAR, Value(""), SetSleepFsFirstByteLatency);
+	config.AddExtensionOption("sleep_fs_connection_bandwidth",
+	                          "Transfer rate of slowfs:// files for each connection in bytes per second; 0 for unlimited",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsBandwidth);
+	config.AddExtensionOption("sleep_fs_max_inflight",
+	                          "slowfs:// requests of the database that may be in flight at once, further requests queue "
+	                          "for a free slot; 0 for unlimited",
+	                          LogicalType::UBIGINT, Value::UBIGINT(0));
+	config.AddExtensionOption("sleep_fs_write_bandwidth",
+	                          "Write rate of slowfs:// files in bytes per second, shared by all queries and checkpoints "
+	                          "of the database; 0 for unlimited",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsBandwidth);
+	config.AddExtensionOption("sleep_fs_query_write_bandwidth",
+	                          "Write rate of slowfs:// files for each query in bytes per second; 0 for unlimited",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsBandwidth);
+	config.AddExtensionOption("sleep_fs_write_burst",
+	                          "Bytes that sleep_fs_write_bandwidth and sleep_fs_query_write_bandwidth admit at once "
+	                          "after the writes have been idle",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsWriteBurst);
+	config.AddExtensionOption("sleep_fs_read_bandwidth",
+	                          "Read rate of slowfs:// files in bytes per second, shared by the connections that read in "
+	                          "proportion to sleep_fs_read_weight; 0 for unlimited",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsBandwidth);
+	config.AddExtensionOption("sleep_fs_read_iops",
+	                          "Read requests per second of slowfs:// files, shared by the connections that read in "
+	                          "proportion to sleep_fs_read_weight; 0 for unlimited",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0), SetSleepFsBandwidth);
+	config.AddExtensionOption("sleep_fs_read_weight",
+	                          "Share of the connection in sleep_fs_read_bandwidth and sleep_fs_read_iops relative to the "
+	                          "other connections that read",
+	                          LogicalType::DOUBLE, Value::DOUBLE(1), SetSleepFsReadWeight);
+	config.AddExtensionOption("sleep_fs_read_burst",
+	                          "Seconds of its share that a connection which has been idle may read at once",
+	                          LogicalType::DOUBLE, Value::DOUBLE(0.1), SetSleepFsReadBurst);
+	config.AddExtensionOption("cpu_duty_cycle",
+	                          "Fraction of each worker thread's time the queries of the connection may spend working; "
+	                          "below 1 the threads sleep between chunks",
+	                          LogicalType::DOUBLE, Value::DOUBLE(1), SetCpuDutyCycle);
+	config.AddExtensionOption("delay_rows_spill_threshold",
+	                          "Rows that delay_rows holds in memory per thread; further input chunks are kept in "
+	                          "buffer-managed storage that can be spilled to the temporary directory",
+	                          LogicalType::UBIGINT, Value::UBIGINT(1048576));
+
 	// Register sleep(seconds)
 	auto sleep = ScalarFunction("sleep", {LogicalType::DOUBLE}, LogicalType::SQLNULL, SleepFunction);
 	sleep.stability = FunctionStability::VOLATILE;
@@ -209,6 +537,48 @@ static void LoadInternal(ExtensionLoader &loader) {
 	sleep_until.stability = FunctionStability::VOLATILE;
 	sleep_until.null_handling = FunctionNullHandling::DEFAULT_NULL_HANDLING;
 	loader.RegisterFunction(sleep_until);
+
+	// Register delay(value, seconds) and delay(value, interval)
+	// NULL durations do not sleep but must not turn the passed-through value into NULL
+	ScalarFunctionSet delay("delay");
+	ScalarFunction delay_seconds({LogicalType::ANY, LogicalType::DOUBLE}, LogicalType::ANY, DelaySecondsFunction,
+	                             DelayBind);
+	delay_seconds.stability = FunctionStability::VOLATILE;
+	delay_seconds.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+	delay.AddFunction(delay_seconds);
+	ScalarFunction delay_interval({LogicalType::ANY, LogicalType::INTERVAL}, LogicalType::ANY, DelayIntervalFunction,
+	                              DelayBind);
+	delay_interval.stability = FunctionStability::VOLATILE;
+	delay_interval.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+	delay.AddFunction(delay_interval);
+	loader.RegisterFunction(delay);
+
+	// Register sleep_now()
+	auto sleep_now = ScalarFunction("sleep_now", {}, LogicalType::TIMESTAMP, SleepNowFunction);
+	sleep_now.stability = FunctionStability::VOLATILE;
+	loader.RegisterFunction(sleep_now);
+
+	// Register sleep_async(seconds | interval) and ticker(interval, count)
+	RegisterAsyncSleepFunctions(loader);
+
+	// Register sleep_random(distribution, p1 [, p2 [, seed]])
+	RegisterRandomSleepFunctions(loader);
+
+	// Register throttle(rows_per_second [, key])
+	RegisterThrottleFunctions(loader);
+
+	// Register replay(table, ts_column, speed := 1.0) and delay_rows(table, delay_column)
+	RegisterReplayFunctions(loader);
+
+	// Serve slowfs:// paths from the rest of the file system, delayed by the sleep_fs_* settings
+	RegisterSleepFileSystem(loader);
+
+	// Register cpu_duty_cycle_stats() and pace the queries of connections with a cpu_duty_cycle below one
+	RegisterDutyCycleFunctions(loader);
+
+	// Register sleep_stats()
+	TableFunction sleep_stats("sleep_stats", {}, SleepStatsFunction, SleepStatsBind, SleepStatsInit);
+	loader.RegisterFunction(sleep_stats);
 }
 
 void SleepExtension::Load(ExtensionLoader &loader) {
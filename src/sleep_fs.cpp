@@ -0,0 +1,829 @@
+#include "sleep_fs.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_opener.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <random>
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// Statistics
+//===--------------------------------------------------------------------===//
+
+struct SleepFileSystemCounters {
+	std::atomic<uint64_t> reads {0};
+	std::atomic<uint64_t> writes {0};
+	std::atomic<uint64_t> syncs {0};
+	std::atomic<uint64_t> seeks {0};
+	std::atomic<uint64_t> bytes_read {0};
+	std::atomic<uint64_t> bytes_written {0};
+	std::atomic<uint64_t> wait_total_us {0};
+	std::atomic<uint64_t> requests {0};
+	std::atomic<uint64_t> queued_total_us {0};
+	std::atomic<uint64_t> first_byte_total_us {0};
+	std::atomic<uint64_t> write_throttles {0};
+	std::atomic<uint64_t> write_throttled_total_us {0};
+	std::atomic<uint64_t> read_throttles {0};
+	std::atomic<uint64_t> read_throttled_total_us {0};
+};
+
+static SleepFileSystemCounters &GetCounters() {
+	static SleepFileSystemCounters counters;
+	return counters;
+}
+
+SleepFileSystemStatistics GetSleepFileSystemStatistics() {
+	auto &counters = GetCounters();
+	SleepFileSystemStatistics result;
+	result.reads = counters.reads.load();
+	result.writes = counters.writes.load();
+	result.syncs = counters.syncs.load();
+	result.seeks = counters.seeks.load();
+	result.bytes_read = counters.bytes_read.load();
+	result.bytes_written = counters.bytes_written.load();
+	result.wait_total_us = counters.wait_total_us.load();
+	result.requests = counters.requests.load();
+	result.queued_total_us = counters.queued_total_us.load();
+	result.first_byte_total_us = counters.first_byte_total_us.load();
+	result.write_throttles = counters.write_throttles.load();
+	result.write_throttled_total_us = counters.write_throttled_total_us.load();
+	result.read_throttles = counters.read_throttles.load();
+	result.read_throttled_total_us = counters.read_throttled_total_us.load();
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// File Handle
+//===--------------------------------------------------------------------===//
+
+SleepFileHandle::SleepFileHandle(FileSystem &file_system, const string &path, FileOpenFlags flags,
+                                 unique_ptr<FileHandle> inner_p)
+    : FileHandle(file_system, path, flags), inner(std::move(inner_p)) {
+}
+
+//===--------------------------------------------------------------------===//
+// Connection State
+//===--------------------------------------------------------------------===//
+
+// Connection on whose behalf the current thread accesses files; file system calls carry no context, so the connection
+// is attached to a thread while the thread runs a task of its query, and to the connection's own thread for the whole
+// query, which also reads files while binding
+struct SleepFileSystemCaller {
+	ClientContext *context = nullptr;
+	SleepFileSystemConnectionState *connection = nullptr;
+};
+
+static thread_local SleepFileSystemCaller task_caller;
+static thread_local SleepFileSystemCaller query_caller;
+
+static SleepFileSystemCaller GetCaller() {
+	return task_caller.context ? task_caller : query_caller;
+}
+
+SleepFileSystemConnectionState::SleepFileSystemConnectionState(idx_t connection_id) {
+	read_statistics.connection_id = connection_id;
+}
+
+shared_ptr<SleepFileSystemConnectionState> SleepFileSystemConnectionState::Get(ClientContext &context) {
+	return context.registered_state->GetOrCreate<SleepFileSystemConnectionState>("sleep_fs",
+	                                                                            context.GetConnectionId());
+}
+
+void SleepFileSystemConnectionState::QueryBegin(ClientContext &context) {
+	std::lock_guard<std::mutex> guard(lock);
+	// A SET between queries takes effect with the next query
+	has_query_settings = false;
+	current_query = SleepFileSystemQueryStatistics();
+	query_write_bucket.reset();
+	query_caller.context = &context;
+	query_caller.connection = this;
+}
+
+void SleepFileSystemConnectionState::QueryEnd(ClientContext &context) {
+	std::lock_guard<std::mutex> guard(lock);
+	last_query = current_query;
+	if (query_caller.connection == this) {
+		query_caller = SleepFileSystemCaller();
+	}
+}
+
+void SleepFileSystemConnectionState::OnTaskStart(ClientContext &context) {
+	task_caller.context = &context;
+	task_caller.connection = this;
+}
+
+void SleepFileSystemConnectionState::OnTaskStop(ClientContext &context) {
+	task_caller = SleepFileSystemCaller();
+}
+
+bool SleepFileSystemConnectionState::TryGetQuerySettings(SleepFileSystemSettings &result) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!has_query_settings) {
+		return false;
+	}
+	result = query_settings;
+	return true;
+}
+
+void SleepFileSystemConnectionState::SetQuerySettings(const SleepFileSystemSettings &settings) {
+	std::lock_guard<std::mutex> guard(lock);
+	query_settings = settings;
+	has_query_settings = true;
+}
+
+void SleepFileSystemConnectionState::Record(const SleepFileSystemQueryStatistics &access) {
+	std::lock_guard<std::mutex> guard(lock);
+	current_query.requests += access.requests;
+	current_query.bytes += access.bytes;
+	current_query.queued_us += access.queued_us;
+	current_query.first_byte_us += access.first_byte_us;
+	current_query.wait_us += access.wait_us;
+	current_query.write_throttled_us += access.write_throttled_us;
+}
+
+SleepFileSystemQueryStatistics SleepFileSystemConnectionState::GetLastQuery() {
+	std::lock_guard<std::mutex> guard(lock);
+	return last_query;
+}
+
+//===--------------------------------------------------------------------===//
+// Settings
+//===--------------------------------------------------------------------===//
+
+SleepFileSystem::SleepFileSystem(DatabaseInstance &db) : db(db), generator(std::random_device()()) {
+}
+
+// Reads a setting of the connection, or the global value when the file is used outside of a query
+static bool TryGetSetting(DatabaseInstance &db, optional_ptr<ClientContext> context, const string &name,
+                          Value &result) {
+	if (context) {
+		return context->TryGetCurrentSetting(name, result) && !result.IsNull();
+	}
+	return db.TryGetCurrentSetting(name, result) && !result.IsNull();
+}
+
+SleepFileSystemSettings SleepFileSystem::GetSettings(optional_ptr<ClientContext> context) {
+	SleepFileSystemSettings settings;
+	Value value;
+	if (TryGetSetting(db, context, "sleep_fs_latency", value)) {
+		settings.latency_micros = SecondsToSleepMicros(value.GetValue<double>());
+	}
+	if (TryGetSetting(db, context, "sleep_fs_seek_latency", value)) {
+		settings.seek_latency_micros = SecondsToSleepMicros(value.GetValue<double>());
+	}
+	if (TryGetSetting(db, context, "sleep_fs_bandwidth", value)) {
+		settings.bandwidth = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_connection_bandwidth", value)) {
+		settings.connection_bandwidth = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_max_inflight", value)) {
+		settings.max_inflight = value.GetValue<uint64_t>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_write_bandwidth", value)) {
+		settings.write_bandwidth = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_query_write_bandwidth", value)) {
+		settings.query_write_bandwidth = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_write_burst", value)) {
+		settings.write_burst = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_read_bandwidth", value)) {
+		settings.read_bandwidth = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_read_iops", value)) {
+		settings.read_iops = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_read_weight", value)) {
+		settings.read_weight = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_read_burst", value)) {
+		settings.read_burst = value.GetValue<double>();
+	}
+	if (TryGetSetting(db, context, "sleep_fs_first_byte_latency", value)) {
+		auto spec = value.ToString();
+		if (!spec.empty()) {
+			// The distribution is parsed again only when the setting changes
+			std::lock_guard<std::mutex> guard(lock);
+			if (spec != first_byte_spec) {
+				first_byte_latency = ParseSleepDistributionSpec("sleep_fs_first_byte_latency", spec);
+				first_byte_spec = spec;
+			}
+			settings.has_first_byte_latency = true;
+			settings.first_byte_latency = first_byte_latency;
+		}
+	}
+	if (context) {
+		settings.clock = GetSleepClock(*context);
+		settings.time_scale = GetSleepTimeScale(*context);
+	} else {
+		if (TryGetSetting(db, context, "sleep_clock", value)) {
+			settings.clock = ParseSleepClock(value.ToString());
+		}
+		if (TryGetSetting(db, context, "sleep_time_scale", value)) {
+			settings.time_scale = value.GetValue<double>();
+		}
+	}
+	return settings;
+}
+
+// Applies a rate to a bucket; arrival times on different clocks are not comparable, so a change of sleep_clock
+// starts a new bucket
+static void ConfigureBucket(shared_ptr<SleepTokenBucket> &bucket, SleepClock clock, double bytes_per_second,
+                            double burst, double time_scale) {
+	if (bucket && bucket->clock == clock) {
+		bucket->Configure(bytes_per_second, burst, time_scale);
+	} else {
+		bucket = make_shared_ptr<SleepTokenBucket>(clock, bytes_per_second, burst, time_scale);
+	}
+}
+
+shared_ptr<SleepTokenBucket> SleepFileSystemConnectionState::GetBandwidthBucket(const SleepFileSystemSettings &settings) {
+	std::lock_guard<std::mutex> guard(lock);
+	ConfigureBucket(bandwidth_bucket, settings.clock, settings.connection_bandwidth, 0, settings.time_scale);
+	return bandwidth_bucket;
+}
+
+shared_ptr<SleepTokenBucket>
+SleepFileSystemConnectionState::GetQueryWriteBucket(const SleepFileSystemSettings &settings) {
+	std::lock_guard<std::mutex> guard(lock);
+	ConfigureBucket(query_write_bucket, settings.clock, settings.query_write_bandwidth, settings.write_burst,
+	                settings.time_scale);
+	return query_write_bucket;
+}
+
+int64_t SleepFileSystemConnectionState::ReserveRead(const SleepFileSystemSettings &settings, double share,
+                                                    int64_t now_ns, idx_t bytes) {
+	std::lock_guard<std::mutex> guard(lock);
+	read_statistics.weight = settings.read_weight;
+	auto ready_ns = now_ns;
+	if (settings.read_bandwidth > 0) {
+		auto rate = settings.read_bandwidth * share;
+		ConfigureBucket(read_bandwidth_bucket, settings.clock, rate, rate * settings.read_burst, settings.time_scale);
+		if (bytes > 0) {
+			ready_ns = MaxValue<int64_t>(ready_ns, read_bandwidth_bucket->Reserve(now_ns, bytes).ready_ns);
+		}
+	}
+	if (settings.read_iops > 0) {
+		auto rate = settings.read_iops * share;
+		ConfigureBucket(read_iops_bucket, settings.clock, rate, rate * settings.read_burst, settings.time_scale);
+		ready_ns = MaxValue<int64_t>(ready_ns, read_iops_bucket->Reserve(now_ns, 1).ready_ns);
+	}
+	return ready_ns;
+}
+
+bool SleepFileSystemConnectionState::IsReadBacklogged(int64_t now_ns) {
+	std::lock_guard<std::mutex> guard(lock);
+	return (read_bandwidth_bucket && !read_bandwidth_bucket->IsIdle(now_ns, 0)) ||
+	       (read_iops_bucket && !read_iops_bucket->IsIdle(now_ns, 0));
+}
+
+double SleepFileSystemConnectionState::GetReadWeight() {
+	std::lock_guard<std::mutex> guard(lock);
+	return read_statistics.weight;
+}
+
+void SleepFileSystemConnectionState::RecordRead(idx_t bytes, int64_t now_ns, int64_t admitted_ns, int64_t finish_ns) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (read_statistics.requests == 0) {
+		read_statistics.first_ns = now_ns;
+	}
+	read_statistics.requests++;
+	read_statistics.bytes += bytes;
+	if (admitted_ns > now_ns) {
+		read_statistics.throttled++;
+	}
+	read_statistics.wait_us += static_cast<uint64_t>(MaxValue<int64_t>(finish_ns - now_ns, 0) / NANOS_PER_MICRO);
+	read_statistics.last_ns = MaxValue<int64_t>(read_statistics.last_ns, finish_ns);
+}
+
+SleepFileSystemReadStatistics SleepFileSystemConnectionState::GetReadStatistics() {
+	std::lock_guard<std::mutex> guard(lock);
+	return read_statistics;
+}
+
+//===--------------------------------------------------------------------===//
+// Read Governor
+//===--------------------------------------------------------------------===//
+
+// Weighted fair sharing in the fluid model: the read rates are divided among the connections whose reads are
+// backlogged, in proportion to their weights, and each connection is paced by token buckets at its share
+// A connection that reads less than its share, e.g. an interactive query next to a scan, finds its buckets idle and
+// passes without waiting, while the scans split whatever it leaves unused
+int64_t SleepFileSystem::GovernRead(ClientContext &context, SleepFileSystemConnectionState &connection,
+                                    const SleepFileSystemSettings &settings, int64_t now_ns, idx_t bytes) {
+	if (!connection.read_governed.exchange(true)) {
+		auto flow = SleepFileSystemConnectionState::Get(context);
+		std::lock_guard<std::mutex> guard(governor_lock);
+		read_flows.push_back(std::move(flow));
+	}
+	if (settings.read_bandwidth <= 0 && settings.read_iops <= 0) {
+		// Ungoverned reads neither take the governor's lock nor look at the other connections
+		return now_ns;
+	}
+	std::lock_guard<std::mutex> guard(governor_lock);
+	double active_weight = settings.read_weight;
+	for (auto it = read_flows.begin(); it != read_flows.end();) {
+		auto flow = it->lock();
+		if (!flow) {
+			it = read_flows.erase(it);
+			continue;
+		}
+		if (flow.get() != &connection && flow->IsReadBacklogged(now_ns)) {
+			active_weight += flow->GetReadWeight();
+		}
+		it++;
+	}
+	return connection.ReserveRead(settings, settings.read_weight / active_weight, now_ns, bytes);
+}
+
+vector<SleepFileSystemReadStatistics> SleepFileSystem::GetReadStatistics() {
+	std::lock_guard<std::mutex> guard(governor_lock);
+	vector<SleepFileSystemReadStatistics> result;
+	for (auto &entry : read_flows) {
+		auto flow = entry.lock();
+		if (flow) {
+			result.push_back(flow->GetReadStatistics());
+		}
+	}
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Delays
+//===--------------------------------------------------------------------===//
+
+void SleepFileSystem::Delay(SleepFileAccess kind, idx_t bytes, bool random_access) {
+	auto caller = GetCaller();
+	auto context = caller.context;
+	auto connection = caller.connection;
+	SleepFileSystemSettings settings;
+	if (!connection || !connection->TryGetQuerySettings(settings)) {
+		settings = GetSettings(context);
+		if (connection) {
+			connection->SetQuerySettings(settings);
+		}
+	}
+	auto &counters = GetCounters();
+	bool access = kind != SleepFileAccess::SEEK;
+	int64_t latency_micros = access ? settings.latency_micros : 0;
+	if (random_access && settings.seek_latency_micros > 0) {
+		counters.seeks.fetch_add(1, std::memory_order_relaxed);
+		latency_micros += settings.seek_latency_micros;
+	}
+	auto now = context ? SleepClockNow(*context, settings.clock) : SleepClockNow(db, settings.clock);
+	// The connection's bucket is taken outside of the file system's lock, it has a lock of its own
+	shared_ptr<SleepTokenBucket> connection_bucket;
+	if (access && settings.connection_bandwidth > 0 && bytes > 0 && connection) {
+		connection_bucket = connection->GetBandwidthBucket(settings);
+	}
+
+	// The write governor holds a write back until the budgets of the database and of the query cover its bytes; it
+	// runs ahead of the device model, so a throttled write does not occupy an in-flight slot while it waits
+	int64_t admitted = now;
+	if (kind == SleepFileAccess::WRITE && bytes > 0) {
+		if (settings.write_bandwidth > 0) {
+			std::lock_guard<std::mutex> guard(lock);
+			ConfigureBucket(write_bucket, settings.clock, settings.write_bandwidth, settings.write_burst,
+			                settings.time_scale);
+			admitted = MaxValue<int64_t>(admitted, write_bucket->Reserve(now, bytes).ready_ns);
+		}
+		if (settings.query_write_bandwidth > 0 && connection) {
+			auto query_bucket = connection->GetQueryWriteBucket(settings);
+			admitted = MaxValue<int64_t>(admitted, query_bucket->Reserve(now, bytes).ready_ns);
+		}
+		if (admitted > now) {
+			counters.write_throttles.fetch_add(1, std::memory_order_relaxed);
+			counters.write_throttled_total_us.fetch_add(static_cast<uint64_t>((admitted - now) / NANOS_PER_MICRO),
+			                                            std::memory_order_relaxed);
+		}
+	}
+	// Likewise the read governor holds back the reads of connections that use more than their fair share
+	if (kind == SleepFileAccess::READ && connection) {
+		admitted = GovernRead(*context, *connection, settings, now, bytes);
+		if (admitted > now) {
+			counters.read_throttles.fetch_add(1, std::memory_order_relaxed);
+			counters.read_throttled_total_us.fetch_add(static_cast<uint64_t>((admitted - now) / NANOS_PER_MICRO),
+			                                           std::memory_order_relaxed);
+		}
+	}
+
+	// A request waits for a free slot, then for its first byte, then for the transfer of its bytes; everything is
+	// planned up front under the lock, so the whole delay is a single interruptible wait
+	int64_t start = admitted;
+	int64_t first_byte;
+	int64_t finish;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (access && settings.max_inflight > 0) {
+			if (inflight_clock != settings.clock) {
+				inflight = decltype(inflight)();
+				inflight_clock = settings.clock;
+			}
+			while (!inflight.empty() && inflight.top() <= start) {
+				inflight.pop();
+			}
+			// Requests beyond the cap start when the earliest request in flight completes, taking over its slot
+			while (inflight.size() >= settings.max_inflight) {
+				start = MaxValue<int64_t>(start, inflight.top());
+				inflight.pop();
+			}
+		}
+		if (access && settings.has_first_byte_latency) {
+			double sample;
+			DrawSleepSamples(generator, settings.first_byte_latency.distribution, settings.first_byte_latency.p1,
+			                 settings.first_byte_latency.p2, &sample, 1);
+			latency_micros += SecondsToSleepMicros(sample);
+		}
+		first_byte =
+		    start + ScaleSleepMicros(ClampSleepMicros(latency_micros), settings.time_scale) * NANOS_PER_MICRO;
+		// The transfer starts with the first byte and queues behind the transfers of the other files
+		finish = first_byte;
+		if (settings.bandwidth > 0 && bytes > 0) {
+			ConfigureBucket(bandwidth_bucket, settings.clock, settings.bandwidth, 0, settings.time_scale);
+			finish = MaxValue<int64_t>(finish, bandwidth_bucket->Reserve(first_byte, bytes).ready_ns);
+		}
+		if (connection_bucket) {
+			finish = MaxValue<int64_t>(finish, connection_bucket->Reserve(first_byte, bytes).ready_ns);
+		}
+		if (access && settings.max_inflight > 0) {
+			inflight.push(finish);
+		}
+	}
+
+	if (access) {
+		counters.requests.fetch_add(1, std::memory_order_relaxed);
+		counters.queued_total_us.fetch_add(static_cast<uint64_t>((start - admitted) / NANOS_PER_MICRO),
+		                                   std::memory_order_relaxed);
+		counters.first_byte_total_us.fetch_add(static_cast<uint64_t>((first_byte - start) / NANOS_PER_MICRO),
+		                                       std::memory_order_relaxed);
+	}
+	counters.wait_total_us.fetch_add(static_cast<uint64_t>(MaxValue<int64_t>(finish - now, 0) / NANOS_PER_MICRO),
+	                                 std::memory_order_relaxed);
+	if (connection) {
+		SleepFileSystemQueryStatistics stats;
+		if (access) {
+			stats.requests = 1;
+			stats.bytes = bytes;
+			stats.queued_us = static_cast<uint64_t>((start - admitted) / NANOS_PER_MICRO);
+			stats.first_byte_us = static_cast<uint64_t>((first_byte - start) / NANOS_PER_MICRO);
+		}
+		stats.wait_us = static_cast<uint64_t>(MaxValue<int64_t>(finish - now, 0) / NANOS_PER_MICRO);
+		if (kind == SleepFileAccess::WRITE) {
+			stats.write_throttled_us = static_cast<uint64_t>((admitted - now) / NANOS_PER_MICRO);
+		}
+		connection->Record(stats);
+		if (kind == SleepFileAccess::READ) {
+			connection->RecordRead(bytes, now, admitted, finish);
+		}
+	}
+	if (finish <= now) {
+		return;
+	}
+	if (context) {
+		PerformSleepUntil(*context, settings.clock, finish);
+	} else {
+		PerformSleepUntil(db, settings.clock, finish);
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// File Operations
+//===--------------------------------------------------------------------===//
+
+string SleepFileSystem::StripPrefix(const string &path) {
+	return path.substr(strlen(PREFIX));
+}
+
+bool SleepFileSystem::CanHandleFile(const string &fpath) {
+	return StringUtil::StartsWith(fpath, PREFIX);
+}
+
+unique_ptr<FileHandle> SleepFileSystem::OpenFile(const string &path, FileOpenFlags flags,
+                                                 optional_ptr<FileOpener> opener) {
+	auto inner = db.GetFileSystem().OpenFile(StripPrefix(path), flags, opener);
+	if (!inner) {
+		// FILE_FLAGS_NULL_IF_NOT_EXISTS
+		return nullptr;
+	}
+	auto context = FileOpener::TryGetClientContext(opener);
+	if (context) {
+		// Registers the connection's state, which attaches the connection to the threads that run its queries
+		SleepFileSystemConnectionState::Get(*context);
+	}
+	return make_uniq<SleepFileHandle>(*this, path, flags, std::move(inner));
+}
+
+void SleepFileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) {
+	auto &sleep_handle = handle.Cast<SleepFileHandle>();
+	auto &counters = GetCounters();
+	counters.reads.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes_read.fetch_add(static_cast<uint64_t>(nr_bytes), std::memory_order_relaxed);
+	auto previous = sleep_handle.next_offset.exchange(location + static_cast<idx_t>(nr_bytes));
+	Delay(SleepFileAccess::READ, static_cast<idx_t>(nr_bytes), location != previous);
+	auto &inner = *sleep_handle.inner;
+	inner.file_system.Read(inner, buffer, nr_bytes, location);
+}
+
+void SleepFileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) {
+	auto &sleep_handle = handle.Cast<SleepFileHandle>();
+	auto &counters = GetCounters();
+	counters.writes.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes_written.fetch_add(static_cast<uint64_t>(nr_bytes), std::memory_order_relaxed);
+	auto previous = sleep_handle.next_offset.exchange(location + static_cast<idx_t>(nr_bytes));
+	Delay(SleepFileAccess::WRITE, static_cast<idx_t>(nr_bytes), location != previous);
+	auto &inner = *sleep_handle.inner;
+	inner.file_system.Write(inner, buffer, nr_bytes, location);
+}
+
+int64_t SleepFileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes) {
+	// Reads at the current position continue the previous access: only an explicit Seek pays the seek latency
+	auto &sleep_handle = handle.Cast<SleepFileHandle>();
+	auto &inner = *sleep_handle.inner;
+	auto bytes_read = inner.file_system.Read(inner, buffer, nr_bytes);
+	auto &counters = GetCounters();
+	counters.reads.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes_read.fetch_add(static_cast<uint64_t>(MaxValue<int64_t>(bytes_read, 0)), std::memory_order_relaxed);
+	Delay(SleepFileAccess::READ, static_cast<idx_t>(MaxValue<int64_t>(bytes_read, 0)), false);
+	sleep_handle.next_offset += static_cast<idx_t>(MaxValue<int64_t>(bytes_read, 0));
+	return bytes_read;
+}
+
+int64_t SleepFileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes) {
+	auto &sleep_handle = handle.Cast<SleepFileHandle>();
+	Delay(SleepFileAccess::WRITE, static_cast<idx_t>(nr_bytes), false);
+	auto &inner = *sleep_handle.inner;
+	auto bytes_written = inner.file_system.Write(inner, buffer, nr_bytes);
+	auto &counters = GetCounters();
+	counters.writes.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes_written.fetch_add(static_cast<uint64_t>(MaxValue<int64_t>(bytes_written, 0)),
+	                                 std::memory_order_relaxed);
+	sleep_handle.next_offset += static_cast<idx_t>(MaxValue<int64_t>(bytes_written, 0));
+	return bytes_written;
+}
+
+void SleepFileSystem::FileSync(FileHandle &handle) {
+	auto &sleep_handle = handle.Cast<SleepFileHandle>();
+	GetCounters().syncs.fetch_add(1, std::memory_order_relaxed);
+	Delay(SleepFileAccess::SYNC, 0, false);
+	auto &inner = *sleep_handle.inner;
+	inner.file_system.FileSync(inner);
+}
+
+void SleepFileSystem::Seek(FileHandle &handle, idx_t location) {
+	auto &sleep_handle = handle.Cast<SleepFileHandle>();
+	if (sleep_handle.next_offset.exchange(location) != location) {
+		// Seeking costs the seek latency; the read that follows continues from here and pays only its own latency
+		Delay(SleepFileAccess::SEEK, 0, true);
+	}
+	auto &inner = *sleep_handle.inner;
+	inner.file_system.Seek(inner, location);
+}
+
+void SleepFileSystem::Reset(FileHandle &handle) {
+	Seek(handle, 0);
+}
+
+idx_t SleepFileSystem::SeekPosition(FileHandle &handle) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	return inner.file_system.SeekPosition(inner);
+}
+
+bool SleepFileSystem::Trim(FileHandle &handle, idx_t offset_bytes, idx_t length_bytes) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	return inner.file_system.Trim(inner, offset_bytes, length_bytes);
+}
+
+int64_t SleepFileSystem::GetFileSize(FileHandle &handle) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	return inner.file_system.GetFileSize(inner);
+}
+
+timestamp_t SleepFileSystem::GetLastModifiedTime(FileHandle &handle) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	return inner.file_system.GetLastModifiedTime(inner);
+}
+
+FileType SleepFileSystem::GetFileType(FileHandle &handle) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	return inner.file_system.GetFileType(inner);
+}
+
+void SleepFileSystem::Truncate(FileHandle &handle, int64_t new_size) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	inner.file_system.Truncate(inner, new_size);
+}
+
+bool SleepFileSystem::OnDiskFile(FileHandle &handle) {
+	auto &inner = *handle.Cast<SleepFileHandle>().inner;
+	return inner.file_system.OnDiskFile(inner);
+}
+
+//===--------------------------------------------------------------------===//
+// Path Operations
+//===--------------------------------------------------------------------===//
+
+bool SleepFileSystem::DirectoryExists(const string &directory, optional_ptr<FileOpener> opener) {
+	return db.GetFileSystem().DirectoryExists(StripPrefix(directory), opener);
+}
+
+void SleepFileSystem::CreateDirectory(const string &directory, optional_ptr<FileOpener> opener) {
+	db.GetFileSystem().CreateDirectory(StripPrefix(directory), opener);
+}
+
+void SleepFileSystem::RemoveDirectory(const string &directory, optional_ptr<FileOpener> opener) {
+	db.GetFileSystem().RemoveDirectory(StripPrefix(directory), opener);
+}
+
+bool SleepFileSystem::ListFiles(const string &directory, const std::function<void(const string &, bool)> &callback,
+                                FileOpener *opener) {
+	return db.GetFileSystem().ListFiles(StripPrefix(directory), callback, opener);
+}
+
+void SleepFileSystem::MoveFile(const string &source, const string &target, optional_ptr<FileOpener> opener) {
+	auto target_path = CanHandleFile(target) ? StripPrefix(target) : target;
+	db.GetFileSystem().MoveFile(StripPrefix(source), target_path, opener);
+}
+
+bool SleepFileSystem::FileExists(const string &filename, optional_ptr<FileOpener> opener) {
+	return db.GetFileSystem().FileExists(StripPrefix(filename), opener);
+}
+
+bool SleepFileSystem::IsPipe(const string &filename, optional_ptr<FileOpener> opener) {
+	return db.GetFileSystem().IsPipe(StripPrefix(filename), opener);
+}
+
+void SleepFileSystem::RemoveFile(const string &filename, optional_ptr<FileOpener> opener) {
+	db.GetFileSystem().RemoveFile(StripPrefix(filename), opener);
+}
+
+vector<OpenFileInfo> SleepFileSystem::Glob(const string &path, FileOpener *opener) {
+	// Matches keep the prefix, so the files they name are opened through this file system again
+	auto result = db.GetFileSystem().Glob(StripPrefix(path), opener);
+	for (auto &file : result) {
+		file.path = PREFIX + file.path;
+	}
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// sleep_fs_query_stats
+//===--------------------------------------------------------------------===//
+
+struct SleepFsQueryStatsState : public GlobalTableFunctionState {
+	SleepFileSystemQueryStatistics stats;
+	bool finished = false;
+};
+
+static unique_ptr<FunctionData> SleepFsQueryStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                      vector<LogicalType> &return_types, vector<string> &names) {
+	for (auto name : {"requests", "bytes", "queued_us", "first_byte_us", "wait_us", "write_throttled_us"}) {
+		names.emplace_back(name);
+		return_types.emplace_back(LogicalType::BIGINT);
+	}
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> SleepFsQueryStatsInit(ClientContext &context,
+                                                                  TableFunctionInitInput &input) {
+	auto result = make_uniq<SleepFsQueryStatsState>();
+	result->stats = SleepFileSystemConnectionState::Get(context)->GetLastQuery();
+	return std::move(result);
+}
+
+// sleep_fs_query_stats()
+// Reports the slowfs:// requests of the previous query on this connection and how long they were delayed
+static void SleepFsQueryStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<SleepFsQueryStatsState>();
+	if (state.finished) {
+		return;
+	}
+	state.finished = true;
+	auto &stats = state.stats;
+	output.SetValue(0, 0, Value::BIGINT(NumericCast<int64_t>(stats.requests)));
+	output.SetValue(1, 0, Value::BIGINT(NumericCast<int64_t>(stats.bytes)));
+	output.SetValue(2, 0, Value::BIGINT(NumericCast<int64_t>(stats.queued_us)));
+	output.SetValue(3, 0, Value::BIGINT(NumericCast<int64_t>(stats.first_byte_us)));
+	output.SetValue(4, 0, Value::BIGINT(NumericCast<int64_t>(stats.wait_us)));
+	output.SetValue(5, 0, Value::BIGINT(NumericCast<int64_t>(stats.write_throttled_us)));
+	output.SetCardinality(1);
+}
+
+//===--------------------------------------------------------------------===//
+// sleep_fs_read_stats
+//===--------------------------------------------------------------------===//
+
+// Gives the table function the file system of the database it was registered for
+struct SleepFileSystemFunctionInfo : public TableFunctionInfo {
+	explicit SleepFileSystemFunctionInfo(SleepFileSystem &file_system) : file_system(file_system) {
+	}
+
+	SleepFileSystem &file_system;
+};
+
+struct SleepFsReadStatsBindData : public TableFunctionData {
+	explicit SleepFsReadStatsBindData(SleepFileSystem &file_system) : file_system(file_system) {
+	}
+
+	SleepFileSystem &file_system;
+};
+
+struct SleepFsReadStatsState : public GlobalTableFunctionState {
+	vector<SleepFileSystemReadStatistics> entries;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SleepFsReadStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                     vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("connection_id");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("weight");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	for (auto name : {"requests", "bytes", "throttled", "wait_us"}) {
+		names.emplace_back(name);
+		return_types.emplace_back(LogicalType::BIGINT);
+	}
+	names.emplace_back("bytes_per_second");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	return make_uniq<SleepFsReadStatsBindData>(input.info->Cast<SleepFileSystemFunctionInfo>().file_system);
+}
+
+static unique_ptr<GlobalTableFunctionState> SleepFsReadStatsInit(ClientContext &context,
+                                                                 TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<SleepFsReadStatsBindData>();
+	auto result = make_uniq<SleepFsReadStatsState>();
+	result->entries = bind_data.file_system.GetReadStatistics();
+	return std::move(result);
+}
+
+// sleep_fs_read_stats()
+// Reports the slowfs:// reads of every open connection, their share under the read governor and their throughput
+static void SleepFsReadStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<SleepFsReadStatsState>();
+	idx_t count = 0;
+	while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &entry = state.entries[state.offset++];
+		output.SetValue(0, count, Value::UBIGINT(entry.connection_id));
+		output.SetValue(1, count, Value::DOUBLE(entry.weight));
+		output.SetValue(2, count, Value::BIGINT(NumericCast<int64_t>(entry.requests)));
+		output.SetValue(3, count, Value::BIGINT(NumericCast<int64_t>(entry.bytes)));
+		output.SetValue(4, count, Value::BIGINT(NumericCast<int64_t>(entry.throttled)));
+		output.SetValue(5, count, Value::BIGINT(NumericCast<int64_t>(entry.wait_us)));
+		// Throughput from the start of the first read to the completion of the last one
+		auto elapsed_ns = entry.last_ns - entry.first_ns;
+		if (elapsed_ns > 0) {
+			auto seconds = static_cast<double>(elapsed_ns) / static_cast<double>(NANOS_PER_SECOND);
+			output.SetValue(6, count, Value::DOUBLE(static_cast<double>(entry.bytes) / seconds));
+		} else {
+			output.SetValue(6, count, Value());
+		}
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+//===--------------------------------------------------------------------===//
+// Registration
+//===--------------------------------------------------------------------===//
+
+// Registers the state of every connection that plans a query, not only of those that opened a file through slowfs://,
+// so reading e.g. a database file attached by another connection is attributed to the reader
+static void SleepFsOptimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	SleepFileSystemConnectionState::Get(input.context);
+}
+
+void RegisterSleepFileSystem(ExtensionLoader &loader) {
+	auto &db = loader.GetDatabaseInstance();
+	auto file_system = make_uniq<SleepFileSystem>(db);
+	// The file system lives as long as the database, like the functions registered for it
+	auto info = make_shared_ptr<SleepFileSystemFunctionInfo>(*file_system);
+	db.GetFileSystem().RegisterSubSystem(std::move(file_system));
+
+	// Register sleep_fs_query_stats()
+	TableFunction query_stats("sleep_fs_query_stats", {}, SleepFsQueryStatsFunction, SleepFsQueryStatsBind,
+	                          SleepFsQueryStatsInit);
+	loader.RegisterFunction(query_stats);
+
+	// Register sleep_fs_read_stats()
+	TableFunction read_stats("sleep_fs_read_stats", {}, SleepFsReadStatsFunction, SleepFsReadStatsBind,
+	                         SleepFsReadStatsInit);
+	read_stats.function_info = std::move(info);
+	loader.RegisterFunction(read_stats);
+
+	OptimizerExtension optimizer;
+	optimizer.optimize_function = SleepFsOptimize;
+	DBConfig::GetConfig(db).optimizer_extensions.push_back(std::move(optimizer));
+}
+
+} // namespace duckdb
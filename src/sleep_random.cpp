@@ -0,0 +1,574 @@
+#include "sleep_random.hpp"
+#include "sleep_engine.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/limits.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/value.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <cmath>
+#include <mutex>
+#include <random>
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// Generator
+//===--------------------------------------------------------------------===//
+
+static uint64_t SplitMix64(uint64_t &x) {
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static inline uint64_t RotateLeft(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+SleepRandomGenerator::SleepRandomGenerator(uint64_t seed) {
+	for (auto &word : state) {
+		word = SplitMix64(seed);
+	}
+}
+
+uint64_t SleepRandomGenerator::Next() {
+	auto result = RotateLeft(state[0] + state[3], 23) + state[0];
+	auto t = state[1] << 17;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = RotateLeft(state[3], 45);
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Distributions
+//===--------------------------------------------------------------------===//
+
+static constexpr double TWO_PI = 6.283185307179586;
+
+// Each distribution fills a whole chunk of samples (in seconds) in one loop, so the per-row work is just the
+// generator step and the transform; p1 and p2 are the distribution's parameters as documented in the README
+struct UniformDistribution {
+	// p1 = lower bound, p2 = upper bound
+	static void Fill(SleepRandomGenerator &generator, double p1, double p2, double *out, idx_t count) {
+		auto width = p2 - p1;
+		for (idx_t i = 0; i < count; i++) {
+			out[i] = p1 + width * generator.NextUnit();
+		}
+	}
+};
+
+struct ExponentialDistribution {
+	// p1 = mean, p2 = shift (a minimum latency added to every sample)
+	static void Fill(SleepRandomGenerator &generator, double p1, double p2, double *out, idx_t count) {
+		for (idx_t i = 0; i < count; i++) {
+			out[i] = p2 - p1 * std::log(generator.NextUnit());
+		}
+	}
+};
+
+// Standard normal samples, two per Box-Muller transform
+static void FillStandardNormal(SleepRandomGenerator &generator, double *out, idx_t count) {
+	for (idx_t i = 0; i < count; i += 2) {
+		auto radius = std::sqrt(-2.0 * std::log(generator.NextUnit()));
+		auto angle = TWO_PI * generator.NextUnit();
+		out[i] = radius * std::cos(angle);
+		if (i + 1 < count) {
+			out[i + 1] = radius * std::sin(angle);
+		}
+	}
+}
+
+struct NormalDistribution {
+	// p1 = mean, p2 = standard deviation
+	static void Fill(SleepRandomGenerator &generator, double p1, double p2, double *out, idx_t count) {
+		FillStandardNormal(generator, out, count);
+		for (idx_t i = 0; i < count; i++) {
+			out[i] = p1 + p2 * out[i];
+		}
+	}
+};
+
+struct LogNormalDistribution {
+	// p1 = mu, p2 = sigma of the underlying normal distribution
+	static void Fill(SleepRandomGenerator &generator, double p1, double p2, double *out, idx_t count) {
+		FillStandardNormal(generator, out, count);
+		for (idx_t i = 0; i < count; i++) {
+			out[i] = std::exp(p1 + p2 * out[i]);
+		}
+	}
+};
+
+struct ParetoDistribution {
+	// p1 = scale (the minimum value), p2 = shape
+	static void Fill(SleepRandomGenerator &generator, double p1, double p2, double *out, idx_t count) {
+		auto exponent = -1.0 / p2;
+		for (idx_t i = 0; i < count; i++) {
+			out[i] = p1 * std::pow(generator.NextUnit(), exponent);
+		}
+	}
+};
+
+struct WeibullDistribution {
+	// p1 = scale, p2 = shape
+	static void Fill(SleepRandomGenerator &generator, double p1, double p2, double *out, idx_t count) {
+		auto exponent = 1.0 / p2;
+		for (idx_t i = 0; i < count; i++) {
+			out[i] = p1 * std::pow(-std::log(generator.NextUnit()), exponent);
+		}
+	}
+};
+
+SleepDistribution ParseSleepDistribution(const string &name) {
+	auto lower = StringUtil::Lower(name);
+	if (lower == "uniform") {
+		return SleepDistribution::UNIFORM;
+	}
+	if (lower == "exponential") {
+		return SleepDistribution::EXPONENTIAL;
+	}
+	if (lower == "normal") {
+		return SleepDistribution::NORMAL;
+	}
+	if (lower == "lognormal") {
+		return SleepDistribution::LOGNORMAL;
+	}
+	if (lower == "pareto") {
+		return SleepDistribution::PARETO;
+	}
+	if (lower == "weibull") {
+		return SleepDistribution::WEIBULL;
+	}
+	throw InvalidInputException("Unrecognized sleep_random distribution '%s', expected one of: uniform, exponential, "
+	                            "normal, lognormal, pareto, weibull",
+	                            name);
+}
+
+void ValidateSleepDistribution(const string &function_name, SleepDistribution distribution, double p1, double p2) {
+	if (!std::isfinite(p1) || !std::isfinite(p2)) {
+		throw InvalidInputException("%s parameters must be finite", function_name);
+	}
+	switch (distribution) {
+	case SleepDistribution::UNIFORM:
+		if (p1 > p2) {
+			throw InvalidInputException("%s: uniform lower bound must not exceed the upper bound", function_name);
+		}
+		break;
+	case SleepDistribution::EXPONENTIAL:
+		if (p1 < 0) {
+			throw InvalidInputException("%s: exponential mean must not be negative", function_name);
+		}
+		break;
+	case SleepDistribution::NORMAL:
+	case SleepDistribution::LOGNORMAL:
+		if (p2 < 0) {
+			throw InvalidInputException("%s: standard deviation must not be negative", function_name);
+		}
+		break;
+	case SleepDistribution::PARETO:
+	case SleepDistribution::WEIBULL:
+		if (p1 <= 0 || p2 <= 0) {
+			throw InvalidInputException("%s: scale and shape must be positive", function_name);
+		}
+		break;
+	}
+}
+
+void DrawSleepSamples(SleepRandomGenerator &generator, SleepDistribution distribution, double p1, double p2,
+                      double *out, idx_t count) {
+	switch (distribution) {
+	case SleepDistribution::UNIFORM:
+		UniformDistribution::Fill(generator, p1, p2, out, count);
+		break;
+	case SleepDistribution::EXPONENTIAL:
+		ExponentialDistribution::Fill(generator, p1, p2, out, count);
+		break;
+	case SleepDistribution::NORMAL:
+		NormalDistribution::Fill(generator, p1, p2, out, count);
+		break;
+	case SleepDistribution::LOGNORMAL:
+		LogNormalDistribution::Fill(generator, p1, p2, out, count);
+		break;
+	case SleepDistribution::PARETO:
+		ParetoDistribution::Fill(generator, p1, p2, out, count);
+		break;
+	case SleepDistribution::WEIBULL:
+		WeibullDistribution::Fill(generator, p1, p2, out, count);
+		break;
+	}
+}
+
+SleepDistributionSpec ParseSleepDistributionSpec(const string &setting_name, const string &spec) {
+	auto open = spec.find('(');
+	auto close = spec.rfind(')');
+	string trailing = close == string::npos ? "" : spec.substr(close + 1);
+	StringUtil::Trim(trailing);
+	if (open == string::npos || close == string::npos || close < open || !trailing.empty()) {
+		throw InvalidInputException("%s: expected a distribution like 'lognormal(-3, 0.5)', got '%s'", setting_name,
+		                            spec);
+	}
+	SleepDistributionSpec result;
+	auto name = spec.substr(0, open);
+	StringUtil::Trim(name);
+	result.distribution = ParseSleepDistribution(name);
+	auto parameters = StringUtil::Split(spec.substr(open + 1, close - open - 1), ',');
+	if (parameters.empty() || parameters.size() > 2 ||
+	    (parameters.size() == 1 && result.distribution != SleepDistribution::EXPONENTIAL)) {
+		throw InvalidInputException("%s: distribution '%s' takes two parameters", setting_name, name);
+	}
+	double values[2] = {0, 0};
+	for (idx_t i = 0; i < parameters.size(); i++) {
+		StringUtil::Trim(parameters[i]);
+		values[i] = Value(parameters[i]).DefaultCastAs(LogicalType::DOUBLE).GetValue<double>();
+	}
+	ValidateSleepDistribution(setting_name, result.distribution, values[0], values[1]);
+	result.p1 = values[0];
+	result.p2 = values[1];
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Bind
+//===--------------------------------------------------------------------===//
+
+// Seed shared by the functions that sleep for random samples
+struct SleepSamplerBindData : public FunctionData {
+	SleepSamplerBindData(bool has_seed, uint64_t seed) : has_seed(has_seed), seed(seed) {
+	}
+
+	bool has_seed;
+	uint64_t seed;
+
+protected:
+	bool SeedEquals(const SleepSamplerBindData &other) const {
+		return has_seed == other.has_seed && seed == other.seed;
+	}
+};
+
+struct SleepRandomBindData : public SleepSamplerBindData {
+	SleepRandomBindData(SleepDistribution distribution, double p1, double p2, bool has_seed, uint64_t seed)
+	    : SleepSamplerBindData(has_seed, seed), distribution(distribution), p1(p1), p2(p2) {
+	}
+
+	SleepDistribution distribution;
+	double p1;
+	double p2;
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<SleepRandomBindData>(distribution, p1, p2, has_seed, seed);
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<SleepRandomBindData>();
+		return distribution == other.distribution && p1 == other.p1 && p2 == other.p2 && SeedEquals(other);
+	}
+};
+
+static Value EvaluateConstantArgument(ClientContext &context, const string &function_name, Expression &argument) {
+	if (!argument.IsFoldable()) {
+		throw BinderException("%s: all arguments must be constants", function_name);
+	}
+	return ExpressionExecutor::EvaluateScalar(context, argument);
+}
+
+// Reads the optional seed argument; NULL leaves the generators unseeded
+static bool EvaluateSeed(ClientContext &context, const string &function_name,
+                         vector<unique_ptr<Expression>> &arguments, idx_t seed_idx, uint64_t &seed) {
+	if (arguments.size() <= seed_idx) {
+		return false;
+	}
+	auto value = EvaluateConstantArgument(context, function_name, *arguments[seed_idx]);
+	if (value.IsNull()) {
+		return false;
+	}
+	seed = static_cast<uint64_t>(value.GetValue<int64_t>());
+	return true;
+}
+
+static unique_ptr<FunctionData> SleepRandomBind(ClientContext &context, ScalarFunction &bound_function,
+                                                vector<unique_ptr<Expression>> &arguments) {
+	auto name = EvaluateConstantArgument(context, "sleep_random", *arguments[0]);
+	auto p1 = EvaluateConstantArgument(context, "sleep_random", *arguments[1]);
+	if (name.IsNull() || p1.IsNull()) {
+		throw InvalidInputException("sleep_random: the distribution and its parameters must not be NULL");
+	}
+	auto distribution = ParseSleepDistribution(name.ToString());
+	// Only the exponential distribution has an optional second parameter: its shift defaults to zero
+	double p2 = 0;
+	if (arguments.size() >= 3) {
+		auto value = EvaluateConstantArgument(context, "sleep_random", *arguments[2]);
+		if (value.IsNull()) {
+			throw InvalidInputException("sleep_random: the distribution and its parameters must not be NULL");
+		}
+		p2 = value.GetValue<double>();
+	} else if (distribution != SleepDistribution::EXPONENTIAL) {
+		throw InvalidInputException("sleep_random: distribution '%s' takes two parameters", name.ToString());
+	}
+	ValidateSleepDistribution("sleep_random", distribution, p1.GetValue<double>(), p2);
+
+	uint64_t seed = 0;
+	auto has_seed = EvaluateSeed(context, "sleep_random", arguments, 3, seed);
+	return make_uniq<SleepRandomBindData>(distribution, p1.GetValue<double>(), p2, has_seed, seed);
+}
+
+//===--------------------------------------------------------------------===//
+// Execution
+//===--------------------------------------------------------------------===//
+
+struct SleepRandomLocalState : public FunctionLocalState {
+	explicit SleepRandomLocalState(uint64_t seed) : generator(seed) {
+	}
+
+	SleepRandomGenerator generator;
+};
+
+// Streams of the seeded samplers of the running query, numbered per function call from zero on every execution
+// Counting per execution rather than in the bind data keeps re-executions (e.g. of a prepared statement) and every
+// other query from shifting the streams that a seed produces
+class SleepSamplerStreams : public ClientContextState {
+public:
+	static shared_ptr<SleepSamplerStreams> Get(ClientContext &context) {
+		return context.registered_state->GetOrCreate<SleepSamplerStreams>("sleep_random_streams");
+	}
+
+	//! Index of the next expression state of the function call; the plan's bind data identifies the call
+	uint64_t Next(const FunctionData &bind_data) {
+		std::lock_guard<std::mutex> guard(lock);
+		return streams[&bind_data]++;
+	}
+
+	void QueryBegin(ClientContext &context) override {
+		std::lock_guard<std::mutex> guard(lock);
+		streams.clear();
+	}
+
+private:
+	std::mutex lock;
+	unordered_map<const FunctionData *, uint64_t> streams;
+};
+
+static unique_ptr<FunctionLocalState> SleepSamplerInitLocal(ExpressionState &state, const BoundFunctionExpression &expr,
+                                                            FunctionData *bind_data_p) {
+	auto &bind_data = bind_data_p->Cast<SleepSamplerBindData>();
+	if (!bind_data.has_seed) {
+		std::random_device device;
+		return make_uniq<SleepRandomLocalState>((static_cast<uint64_t>(device()) << 32) ^ device());
+	}
+	// The first state of an execution replays the seed exactly, the states of further threads continue on distinct
+	// streams; which rows a thread samples still depends on the scheduling, so only single-threaded plans replay
+	// row by row
+	uint64_t stream = 0;
+	if (state.HasContext()) {
+		stream = SleepSamplerStreams::Get(state.GetContext())->Next(bind_data);
+	}
+	return make_uniq<SleepRandomLocalState>(bind_data.seed + stream * 0xD1B54A32D192ED03ULL);
+}
+
+// Sleeps for a chunk of sampled durations and returns them in seconds
+static void SleepForSamples(ClientContext &context, const int64_t *samples, idx_t count, Vector &result) {
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_data = FlatVector::GetData<double>(result);
+	ChunkSleep chunk_sleep(context, GetSleepVectorMode(context));
+	for (idx_t i = 0; i < count; i++) {
+		result_data[i] = static_cast<double>(samples[i]) / static_cast<double>(Interval::MICROS_PER_SEC);
+		if (samples[i] > 0) {
+			chunk_sleep.Add(samples[i]);
+		}
+	}
+	chunk_sleep.Finish();
+}
+
+// sleep_random(distribution, p1 [, p2 [, seed]])
+// Draws a duration in seconds per row from the distribution, sleeps for it and returns it
+static void SleepRandomFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto &bind_data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<SleepRandomBindData>();
+	auto &generator = ExecuteFunctionState::GetFunctionState(state)->Cast<SleepRandomLocalState>().generator;
+	auto count = args.size();
+
+	double samples[STANDARD_VECTOR_SIZE];
+	DrawSleepSamples(generator, bind_data.distribution, bind_data.p1, bind_data.p2, samples, count);
+
+	// Negative samples (e.g. the left tail of a normal distribution) do not sleep and are reported as zero
+	int64_t durations[STANDARD_VECTOR_SIZE];
+	for (idx_t i = 0; i < count; i++) {
+		durations[i] = SecondsToSleepMicros(samples[i]);
+	}
+	SleepForSamples(context, durations, count, result);
+}
+
+//===--------------------------------------------------------------------===//
+// Histogram Sampling
+//===--------------------------------------------------------------------===//
+
+// Walker's alias table over the buckets of a histogram, built once at bind time (Vose's construction)
+// A sample picks a bucket uniformly and keeps it with its probability, otherwise takes its alias: O(1) per draw
+struct SleepHistogramBindData : public SleepSamplerBindData {
+	SleepHistogramBindData(vector<int64_t> durations, vector<double> probability, vector<uint32_t> alias,
+	                       bool has_seed, uint64_t seed)
+	    : SleepSamplerBindData(has_seed, seed), durations(std::move(durations)), probability(std::move(probability)),
+	      alias(std::move(alias)) {
+	}
+
+	//! Bucket durations in microseconds, converted and clamped once
+	vector<int64_t> durations;
+	vector<double> probability;
+	vector<uint32_t> alias;
+
+	int64_t Sample(SleepRandomGenerator &generator) const {
+		auto bucket = generator.NextBounded(static_cast<uint32_t>(durations.size()));
+		// NextUnit is never zero, so buckets with a probability of zero always defer to their alias
+		return durations[generator.NextUnit() <= probability[bucket] ? bucket : alias[bucket]];
+	}
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<SleepHistogramBindData>(durations, probability, alias, has_seed, seed);
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<SleepHistogramBindData>();
+		return durations == other.durations && probability == other.probability && alias == other.alias &&
+		       SeedEquals(other);
+	}
+};
+
+static vector<double> EvaluateHistogramList(ClientContext &context, Expression &argument, const char *name) {
+	auto list = EvaluateConstantArgument(context, "sleep_from_histogram", argument);
+	if (list.IsNull()) {
+		throw InvalidInputException("sleep_from_histogram: %s must not be NULL", name);
+	}
+	vector<double> result;
+	for (auto &element : ListValue::GetChildren(list)) {
+		if (element.IsNull()) {
+			throw InvalidInputException("sleep_from_histogram: %s must not contain NULL", name);
+		}
+		auto value = element.GetValue<double>();
+		if (!std::isfinite(value)) {
+			throw InvalidInputException("sleep_from_histogram: %s must be finite", name);
+		}
+		result.push_back(value);
+	}
+	return result;
+}
+
+static unique_ptr<FunctionData> SleepFromHistogramBind(ClientContext &context, ScalarFunction &bound_function,
+                                                       vector<unique_ptr<Expression>> &arguments) {
+	auto buckets = EvaluateHistogramList(context, *arguments[0], "buckets");
+	auto weights = EvaluateHistogramList(context, *arguments[1], "weights");
+	if (buckets.empty() || buckets.size() != weights.size()) {
+		throw InvalidInputException("sleep_from_histogram: buckets and weights must be non-empty lists of equal length");
+	}
+	if (buckets.size() > NumericLimits<uint32_t>::Maximum()) {
+		throw InvalidInputException("sleep_from_histogram: too many buckets");
+	}
+	double total_weight = 0;
+	for (auto weight : weights) {
+		if (weight < 0) {
+			throw InvalidInputException("sleep_from_histogram: weights must not be negative");
+		}
+		total_weight += weight;
+	}
+	if (total_weight <= 0) {
+		throw InvalidInputException("sleep_from_histogram: at least one weight must be positive");
+	}
+
+	auto bucket_count = buckets.size();
+	vector<int64_t> durations;
+	for (auto seconds : buckets) {
+		durations.push_back(SecondsToSleepMicros(seconds));
+	}
+	vector<double> probability(bucket_count, 1.0);
+	vector<uint32_t> alias(bucket_count);
+	vector<double> scaled;
+	vector<uint32_t> small;
+	vector<uint32_t> large;
+	for (uint32_t i = 0; i < bucket_count; i++) {
+		alias[i] = i;
+		scaled.push_back(weights[i] * static_cast<double>(bucket_count) / total_weight);
+		(scaled[i] < 1.0 ? small : large).push_back(i);
+	}
+	// Pair every under-full bucket with an over-full one that donates the rest of its column
+	while (!small.empty() && !large.empty()) {
+		auto lesser = small.back();
+		small.pop_back();
+		auto greater = large.back();
+		probability[lesser] = scaled[lesser];
+		alias[lesser] = greater;
+		scaled[greater] = (scaled[greater] + scaled[lesser]) - 1.0;
+		if (scaled[greater] < 1.0) {
+			large.pop_back();
+			small.push_back(greater);
+		}
+	}
+	// Whatever remains is full up to rounding error and keeps a probability of one
+
+	uint64_t seed = 0;
+	auto has_seed = EvaluateSeed(context, "sleep_from_histogram", arguments, 2, seed);
+	return make_uniq<SleepHistogramBindData>(std::move(durations), std::move(probability), std::move(alias), has_seed,
+	                                         seed);
+}
+
+// sleep_from_histogram(buckets, weights [, seed])
+// Draws one of the bucket durations (in seconds) per row with probability proportional to its weight, sleeps for it
+// and returns it
+static void SleepFromHistogramFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto &bind_data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<SleepHistogramBindData>();
+	auto &generator = ExecuteFunctionState::GetFunctionState(state)->Cast<SleepRandomLocalState>().generator;
+	auto count = args.size();
+
+	int64_t durations[STANDARD_VECTOR_SIZE];
+	for (idx_t i = 0; i < count; i++) {
+		durations[i] = bind_data.Sample(generator);
+	}
+	SleepForSamples(context, durations, count, result);
+}
+
+//===--------------------------------------------------------------------===//
+// Registration
+//===--------------------------------------------------------------------===//
+
+static ScalarFunction MakeSamplerFunction(vector<LogicalType> arguments, scalar_function_t function_p,
+                                          bind_scalar_function_t bind) {
+	ScalarFunction function(std::move(arguments), LogicalType::DOUBLE, std::move(function_p), bind);
+	function.init_local_state = SleepSamplerInitLocal;
+	function.stability = FunctionStability::VOLATILE;
+	// The arguments are constants that the bind already validated, including NULL checks
+	function.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+	return function;
+}
+
+void RegisterRandomSleepFunctions(ExtensionLoader &loader) {
+	// Register sleep_random(distribution, p1 [, p2 [, seed]])
+	ScalarFunctionSet sleep_random("sleep_random");
+	sleep_random.AddFunction(
+	    MakeSamplerFunction({LogicalType::VARCHAR, LogicalType::DOUBLE}, SleepRandomFunction, SleepRandomBind));
+	sleep_random.AddFunction(MakeSamplerFunction({LogicalType::VARCHAR, LogicalType::DOUBLE, LogicalType::DOUBLE},
+	                                             SleepRandomFunction, SleepRandomBind));
+	sleep_random.AddFunction(
+	    MakeSamplerFunction({LogicalType::VARCHAR, LogicalType::DOUBLE, LogicalType::DOUBLE, LogicalType::BIGINT},
+	                        SleepRandomFunction, SleepRandomBind));
+	loader.RegisterFunction(sleep_random);
+
+	// Register sleep_from_histogram(buckets, weights [, seed])
+	ScalarFunctionSet sleep_from_histogram("sleep_from_histogram");
+	auto list_type = LogicalType::LIST(LogicalType::DOUBLE);
+	sleep_from_histogram.AddFunction(
+	    MakeSamplerFunction({list_type, list_type}, SleepFromHistogramFunction, SleepFromHistogramBind));
+	sleep_from_histogram.AddFunction(MakeSamplerFunction({list_type, list_type, LogicalType::BIGINT},
+	                                                     SleepFromHistogramFunction, SleepFromHistogramBind));
+	loader.RegisterFunction(sleep_from_histogram);
+}
+
+} // namespace duckdb
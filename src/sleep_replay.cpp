@@ -0,0 +1,707 @@
+#include "sleep_replay.hpp"
+#include "sleep_engine.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/limits.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/column/column_data_allocator.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace duckdb {
+
+// Deadlines are capped this far (about 146 years) after the anchor, so adding them to a clock cannot overflow
+static constexpr int64_t MAX_REPLAY_OFFSET_NS = NumericLimits<int64_t>::Maximum() / 2;
+
+//===--------------------------------------------------------------------===//
+// Bind
+//===--------------------------------------------------------------------===//
+
+struct ReplayBindData : public TableFunctionData {
+	ReplayBindData(idx_t ts_column, double speed) : ts_column(ts_column), speed(speed) {
+	}
+
+	//! Input column holding the recorded event time
+	idx_t ts_column;
+	//! Recorded time that passes per unit of replay time
+	double speed;
+};
+
+static bool IsReplayTimestampType(const LogicalType &type) {
+	switch (type.id()) {
+	case LogicalTypeId::DATE:
+	case LogicalTypeId::TIMESTAMP:
+	case LogicalTypeId::TIMESTAMP_TZ:
+	case LogicalTypeId::TIMESTAMP_SEC:
+	case LogicalTypeId::TIMESTAMP_MS:
+	case LogicalTypeId::TIMESTAMP_NS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Returns the input column named by the last positional argument (the table argument comes first)
+static idx_t BindInputColumn(TableFunctionBindInput &input, const string &function_name, string &name) {
+	auto &column_name = input.inputs.back();
+	if (column_name.IsNull()) {
+		throw InvalidInputException("%s: the column name must not be NULL", function_name);
+	}
+	name = StringValue::Get(column_name);
+	for (idx_t col_idx = 0; col_idx < input.input_table_names.size(); col_idx++) {
+		if (StringUtil::CIEquals(input.input_table_names[col_idx], name)) {
+			return col_idx;
+		}
+	}
+	throw BinderException("%s: column \"%s\" does not exist in the input", function_name, name);
+}
+
+static unique_ptr<FunctionData> ReplayBind(ClientContext &context, TableFunctionBindInput &input,
+                                           vector<LogicalType> &return_types, vector<string> &names) {
+	string name;
+	auto ts_column = BindInputColumn(input, "replay", name);
+	if (!IsReplayTimestampType(input.input_table_types[ts_column])) {
+		throw BinderException("replay: column \"%s\" must be a DATE or TIMESTAMP, not %s", name,
+		                      input.input_table_types[ts_column].ToString());
+	}
+
+	double speed = 1.0;
+	auto entry = input.named_parameters.find("speed");
+	if (entry != input.named_parameters.end() && !entry->second.IsNull()) {
+		speed = entry->second.GetValue<double>();
+	}
+	if (!std::isfinite(speed) || speed <= 0) {
+		throw InvalidInputException("replay: speed must be a positive, finite number");
+	}
+
+	// Rows pass through unchanged
+	return_types = input.input_table_types;
+	names = input.input_table_names;
+	return make_uniq<ReplayBindData>(ts_column, speed);
+}
+
+//===--------------------------------------------------------------------===//
+// State
+//===--------------------------------------------------------------------===//
+
+// The replay is anchored once, when the first chunk arrives: its earliest event is due right away and every other
+// event is due its (scaled) distance from that event after the anchor, so waits never accumulate drift
+// PhysicalReplayInput keeps the input on a single thread and in order, so the first chunk holds the earliest events
+// of a recording in time order instead of whichever chunk a parallel scan happens to produce first
+struct ReplayGlobalState : public GlobalTableFunctionState {
+	ReplayGlobalState(ClientContext &context, const ReplayBindData &bind_data)
+	    : clock(GetSleepClock(context)),
+	      ns_per_micro(static_cast<double>(NANOS_PER_MICRO) * GetSleepTimeScale(context) / bind_data.speed) {
+	}
+
+	SleepClock clock;
+	//! Replay nanoseconds per recorded microsecond, combining speed and sleep_time_scale
+	double ns_per_micro;
+
+	std::mutex lock;
+	bool anchored = false;
+	//! Recorded time of the first event and the clock time it was replayed at
+	int64_t first_micros = 0;
+	int64_t anchor_ns = 0;
+
+	//! Anchors the replay on its first call, returns the anchor
+	void Anchor(ClientContext &context, int64_t first_event_micros, int64_t &first, int64_t &anchor) {
+		std::lock_guard<std::mutex> guard(lock);
+		if (!anchored) {
+			anchored = true;
+			first_micros = first_event_micros;
+			anchor_ns = SleepClockNow(context, clock);
+		}
+		first = first_micros;
+		anchor = anchor_ns;
+	}
+};
+
+// Deadlines of the current input chunk, and the order in which its rows come due
+struct ReplayLocalState : public LocalTableFunctionState {
+	vector<int64_t> deadlines;
+	vector<sel_t> order;
+	//! Rows of the order that have been emitted
+	idx_t position = 0;
+	SelectionVector sel;
+};
+
+static unique_ptr<GlobalTableFunctionState> ReplayInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+	return make_uniq<ReplayGlobalState>(context, input.bind_data->Cast<ReplayBindData>());
+}
+
+static unique_ptr<LocalTableFunctionState> ReplayInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                           GlobalTableFunctionState *global_state) {
+	auto result = make_uniq<ReplayLocalState>();
+	result->sel.Initialize(STANDARD_VECTOR_SIZE);
+	return std::move(result);
+}
+
+//===--------------------------------------------------------------------===//
+// Replay
+//===--------------------------------------------------------------------===//
+
+// Computes when each row of the chunk is due and sorts the rows by it
+// Rows without a finite event time are due immediately
+static void ScheduleChunk(ClientContext &context, ReplayGlobalState &gstate, const ReplayBindData &bind_data,
+                          DataChunk &input, ReplayLocalState &lstate) {
+	auto count = input.size();
+	auto &source = input.data[bind_data.ts_column];
+	Vector timestamps(LogicalType::TIMESTAMP, count);
+	auto source_type = source.GetType().id();
+	if (source_type == LogicalTypeId::TIMESTAMP || source_type == LogicalTypeId::TIMESTAMP_TZ) {
+		timestamps.Reference(source);
+	} else {
+		VectorOperations::Cast(context, source, timestamps, count);
+	}
+	UnifiedVectorFormat format;
+	timestamps.ToUnifiedFormat(count, format);
+	auto data = UnifiedVectorFormat::GetData<timestamp_t>(format);
+
+	auto first_event = NumericLimits<int64_t>::Maximum();
+	for (idx_t row = 0; row < count; row++) {
+		auto idx = format.sel->get_index(row);
+		if (format.validity.RowIsValid(idx) && Timestamp::IsFinite(data[idx])) {
+			first_event = MinValue<int64_t>(first_event, data[idx].value);
+		}
+	}
+	int64_t first_micros = 0;
+	int64_t anchor_ns = 0;
+	if (first_event == NumericLimits<int64_t>::Maximum()) {
+		// Nothing in this chunk is scheduled: do not anchor the replay on it
+		lstate.deadlines.assign(count, NumericLimits<int64_t>::Minimum());
+	} else {
+		gstate.Anchor(context, first_event, first_micros, anchor_ns);
+		lstate.deadlines.resize(count);
+		for (idx_t row = 0; row < count; row++) {
+			auto idx = format.sel->get_index(row);
+			if (!format.validity.RowIsValid(idx) || !Timestamp::IsFinite(data[idx])) {
+				lstate.deadlines[row] = NumericLimits<int64_t>::Minimum();
+				continue;
+			}
+			// Events before the first one are due right away
+			auto offset = static_cast<double>(data[idx].value - first_micros) * gstate.ns_per_micro;
+			auto offset_ns = offset < static_cast<double>(MAX_REPLAY_OFFSET_NS) ? static_cast<int64_t>(offset)
+			                                                                    : MAX_REPLAY_OFFSET_NS;
+			lstate.deadlines[row] = anchor_ns + MaxValue<int64_t>(offset_ns, 0);
+		}
+	}
+
+	lstate.order.resize(count);
+	for (idx_t row = 0; row < count; row++) {
+		lstate.order[row] = static_cast<sel_t>(row);
+	}
+	// Recordings are usually in time order already, only sort chunks that are not
+	auto &deadlines = lstate.deadlines;
+	if (!std::is_sorted(deadlines.begin(), deadlines.end())) {
+		std::stable_sort(lstate.order.begin(), lstate.order.end(),
+		                 [&](sel_t a, sel_t b) { return deadlines[a] < deadlines[b]; });
+	}
+	lstate.position = 0;
+}
+
+// Emits the rows of the input chunk as they come due: waits for the next pending row, then emits every row that is
+// due by then in a single chunk, so a replay that runs behind catches up in large chunks instead of one row per wait
+static OperatorResultType ReplayFunction(ExecutionContext &context, TableFunctionInput &data_p, DataChunk &input,
+                                         DataChunk &output) {
+	auto &bind_data = data_p.bind_data->Cast<ReplayBindData>();
+	auto &gstate = data_p.global_state->Cast<ReplayGlobalState>();
+	auto &lstate = data_p.local_state->Cast<ReplayLocalState>();
+	auto count = input.size();
+	if (count == 0) {
+		return OperatorResultType::NEED_MORE_INPUT;
+	}
+	if (lstate.position == 0) {
+		ScheduleChunk(context.client, gstate, bind_data, input, lstate);
+	}
+
+	auto next_deadline = lstate.deadlines[lstate.order[lstate.position]];
+	auto now = SleepClockNow(context.client, gstate.clock);
+	if (next_deadline > now) {
+		PerformSleepUntil(context.client, gstate.clock, next_deadline);
+		now = MaxValue<int64_t>(SleepClockNow(context.client, gstate.clock), next_deadline);
+	}
+	idx_t emitted = 0;
+	while (lstate.position < count && lstate.deadlines[lstate.order[lstate.position]] <= now) {
+		lstate.sel.set_index(emitted++, lstate.order[lstate.position++]);
+	}
+	output.Slice(input, lstate.sel, emitted);
+
+	if (lstate.position < count) {
+		return OperatorResultType::HAVE_MORE_OUTPUT;
+	}
+	lstate.position = 0;
+	return OperatorResultType::NEED_MORE_INPUT;
+}
+
+//===--------------------------------------------------------------------===//
+// Ordered Input
+//===--------------------------------------------------------------------===//
+
+// Pass-through operator below a replay; it is not a parallel operator, so DuckDB schedules the pipeline that feeds the
+// replay as a single task that reads its source in order
+class PhysicalReplayInput : public PhysicalOperator {
+public:
+	static constexpr const PhysicalOperatorType TYPE = PhysicalOperatorType::EXTENSION;
+
+	PhysicalReplayInput(PhysicalPlan &physical_plan, vector<LogicalType> types, idx_t estimated_cardinality)
+	    : PhysicalOperator(physical_plan, PhysicalOperatorType::EXTENSION, std::move(types), estimated_cardinality) {
+	}
+
+public:
+	string GetName() const override {
+		return "REPLAY_INPUT";
+	}
+
+	OperatorResultType Execute(ExecutionContext &context, DataChunk &input, DataChunk &chunk,
+	                           GlobalOperatorState &gstate, OperatorState &state) const override {
+		chunk.Reference(input);
+		return OperatorResultType::NEED_MORE_INPUT;
+	}
+};
+
+// Placed between a replay and its input, keeping the input's column bindings
+class LogicalReplayInput : public LogicalExtensionOperator {
+public:
+	explicit LogicalReplayInput(unique_ptr<LogicalOperator> child) {
+		if (child->has_estimated_cardinality) {
+			SetEstimatedCardinality(child->estimated_cardinality);
+		}
+		children.push_back(std::move(child));
+	}
+
+public:
+	vector<ColumnBinding> GetColumnBindings() override {
+		return children[0]->GetColumnBindings();
+	}
+
+	PhysicalOperator &CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) override {
+		auto &child = planner.CreatePlan(*children[0]);
+		auto &input = planner.Make<PhysicalReplayInput>(types, estimated_cardinality);
+		input.children.push_back(child);
+		return input;
+	}
+
+	string GetExtensionName() const override {
+		return "sleep";
+	}
+
+protected:
+	void ResolveTypes() override {
+		types = children[0]->types;
+	}
+};
+
+static void SerializeReplayInputs(unique_ptr<LogicalOperator> &op) {
+	for (auto &child : op->children) {
+		SerializeReplayInputs(child);
+	}
+	if (op->type == LogicalOperatorType::LOGICAL_GET && op->Cast<LogicalGet>().function.name == "replay" &&
+	    op->children.size() == 1) {
+		auto &input = op->children[0];
+		input->ResolveOperatorTypes();
+		input = make_uniq<LogicalReplayInput>(std::move(input));
+		input->ResolveOperatorTypes();
+	}
+}
+
+// Without the optimizer (PRAGMA disable_optimizer) the input of a replay may still be read by several threads
+static void ReplayOptimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	SerializeReplayInputs(plan);
+}
+
+//===--------------------------------------------------------------------===//
+// Delay Queue
+//===--------------------------------------------------------------------===//
+
+struct DelayRowsBindData : public TableFunctionData {
+	explicit DelayRowsBindData(idx_t delay_column) : delay_column(delay_column) {
+	}
+
+	//! Input column holding each row's delay, in seconds or as an interval
+	idx_t delay_column;
+};
+
+static unique_ptr<FunctionData> DelayRowsBind(ClientContext &context, TableFunctionBindInput &input,
+                                              vector<LogicalType> &return_types, vector<string> &names) {
+	string name;
+	auto delay_column = BindInputColumn(input, "delay_rows", name);
+	auto &type = input.input_table_types[delay_column];
+	if (type.id() != LogicalTypeId::INTERVAL && !type.IsNumeric()) {
+		throw BinderException("delay_rows: column \"%s\" must be a number of seconds or an INTERVAL, not %s", name,
+		                      type.ToString());
+	}
+	return_types = input.input_table_types;
+	names = input.input_table_names;
+	return make_uniq<DelayRowsBindData>(delay_column);
+}
+
+static idx_t GetDelayRowsSpillThreshold(ClientContext &context) {
+	Value threshold;
+	if (!context.TryGetCurrentSetting("delay_rows_spill_threshold", threshold) || threshold.IsNull()) {
+		return 1048576;
+	}
+	return threshold.GetValue<uint64_t>();
+}
+
+// Rows of a spilled run that are buffered in memory while the run takes part in the merge
+static constexpr idx_t SPILL_HEAD_ROWS = 256;
+
+// An input chunk whose rows are held until their release time
+// Chunks that arrive while the thread already holds spill_threshold rows are spilled right away: their rows are
+// sorted by release time and appended, with their release times and arrival order, to a buffer-managed run that
+// DuckDB can evict to the temporary directory. The runs are merged with the held rows through the heap: a run has a
+// single heap entry for its next row, and only the next SPILL_HEAD_ROWS rows of a run that started releasing are
+// buffered in memory, so neither its rows nor per-row heap entries stay in memory
+struct DelayHeldChunk {
+	//! The rows, in memory; unset while the chunk is spilled
+	unique_ptr<DataChunk> chunk;
+	//! The sorted run of a spilled chunk, with the release time and arrival order of each row as extra last columns
+	unique_ptr<ColumnDataCollection> run;
+	//! The rows of the run that are buffered for the merge, and the next row to release among them
+	unique_ptr<DataChunk> head;
+	idx_t cursor = 0;
+	//! Chunk of the run the next rows are buffered from, and the first row of it that is not buffered yet
+	idx_t run_chunk = 0;
+	idx_t run_offset = 0;
+	//! Rows that have not been released yet; the chunk is dropped once it reaches zero
+	idx_t remaining = 0;
+};
+
+struct DelayHeapEntry {
+	int64_t deadline_ns;
+	//! Arrival order, so rows with the same release time leave in the order they came in
+	uint64_t sequence;
+	uint32_t slot;
+	//! Row of the in-memory chunk; a spilled run releases the row at its cursor
+	sel_t row;
+};
+
+// Min-heap order for std::push_heap, which keeps the largest element on top
+static bool DelayReleasesLater(const DelayHeapEntry &a, const DelayHeapEntry &b) {
+	return a.deadline_ns != b.deadline_ns ? a.deadline_ns > b.deadline_ns : a.sequence > b.sequence;
+}
+
+// Rows held by one thread, ordered by release time
+// Holding is per thread: each thread releases the rows it consumed, so no lock is taken per row
+struct DelayRowsLocalState : public LocalTableFunctionState {
+	explicit DelayRowsLocalState(ClientContext &context)
+	    : clock(GetSleepClock(context)), time_scale(GetSleepTimeScale(context)),
+	      spill_threshold(GetDelayRowsSpillThreshold(context)) {
+	}
+
+	SleepClock clock;
+	double time_scale;
+	//! Rows held in memory before further chunks are spilled
+	idx_t spill_threshold;
+
+	vector<DelayHeapEntry> heap;
+	vector<DelayHeldChunk> slots;
+	vector<uint32_t> free_slots;
+	uint64_t next_sequence = 0;
+	idx_t rows_in_memory = 0;
+	//! Whether the current input chunk has been added to the heap
+	bool absorbed = false;
+	//! Due rows of due_source that are copied to the output together
+	SelectionVector sel;
+	DataChunk *due_source = nullptr;
+	idx_t due_count = 0;
+
+	//! Allocator shared by the runs of all spilled chunks, so small runs share their blocks
+	shared_ptr<ColumnDataAllocator> spill_allocator;
+	idx_t spilled_chunks = 0;
+	//! Chunk of a run that is fetched to buffer its next rows
+	DataChunk fetched;
+};
+
+static unique_ptr<LocalTableFunctionState> DelayRowsInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                              GlobalTableFunctionState *global_state) {
+	auto result = make_uniq<DelayRowsLocalState>(context.client);
+	result->sel.Initialize(STANDARD_VECTOR_SIZE);
+	return std::move(result);
+}
+
+// Sorts the rows of a chunk by release time and appends them, with their release times and arrival order, to a run
+static void SpillChunk(ClientContext &context, DelayRowsLocalState &lstate, DataChunk &input,
+                       const vector<int64_t> &deadlines, uint64_t sequence, DelayHeldChunk &held) {
+	auto count = input.size();
+	if (!lstate.spill_allocator) {
+		lstate.spill_allocator = make_shared_ptr<ColumnDataAllocator>(BufferManager::GetBufferManager(context));
+	}
+	auto types = input.GetTypes();
+	types.push_back(LogicalType::BIGINT);
+	types.push_back(LogicalType::UBIGINT);
+	held.run = make_uniq<ColumnDataCollection>(lstate.spill_allocator, types);
+
+	vector<sel_t> order(count);
+	for (idx_t row = 0; row < count; row++) {
+		order[row] = static_cast<sel_t>(row);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](sel_t a, sel_t b) { return deadlines[a] < deadlines[b]; });
+	SelectionVector sel(order.data());
+
+	DataChunk run;
+	run.Initialize(Allocator::Get(context), types);
+	auto deadline_column = input.ColumnCount();
+	for (idx_t col_idx = 0; col_idx < deadline_column; col_idx++) {
+		VectorOperations::Copy(input.data[col_idx], run.data[col_idx], sel, count, 0, 0);
+	}
+	auto run_deadlines = FlatVector::GetData<int64_t>(run.data[deadline_column]);
+	auto run_sequences = FlatVector::GetData<uint64_t>(run.data[deadline_column + 1]);
+	for (idx_t i = 0; i < count; i++) {
+		run_deadlines[i] = deadlines[order[i]];
+		run_sequences[i] = sequence + order[i];
+	}
+	run.SetCardinality(count);
+	held.run->Append(run);
+	lstate.spilled_chunks++;
+}
+
+// Buffers the next rows of a spilled run, walking the chunks that were appended to it in order
+static void LoadRunHead(ClientContext &context, DelayRowsLocalState &lstate, DelayHeldChunk &held) {
+	auto &run = *held.run;
+	if (lstate.fetched.ColumnCount() == 0) {
+		run.InitializeScanChunk(lstate.fetched);
+	}
+	if (!held.head) {
+		held.head = make_uniq<DataChunk>();
+		held.head->Initialize(Allocator::Get(context), run.Types(), SPILL_HEAD_ROWS);
+	}
+	auto &fetched = lstate.fetched;
+	while (true) {
+		D_ASSERT(held.run_chunk < run.ChunkCount());
+		fetched.Reset();
+		run.FetchChunk(held.run_chunk, fetched);
+		if (held.run_offset < fetched.size()) {
+			break;
+		}
+		held.run_chunk++;
+		held.run_offset = 0;
+	}
+	auto &head = *held.head;
+	auto rows = MinValue<idx_t>(fetched.size() - held.run_offset, SPILL_HEAD_ROWS);
+	head.Reset();
+	for (idx_t col_idx = 0; col_idx < head.ColumnCount(); col_idx++) {
+		VectorOperations::Copy(fetched.data[col_idx], head.data[col_idx], held.run_offset + rows, held.run_offset, 0);
+	}
+	head.SetCardinality(rows);
+	held.run_offset += rows;
+	held.cursor = 0;
+}
+
+static void ReleaseSlot(DelayRowsLocalState &lstate, uint32_t slot) {
+	auto &held = lstate.slots[slot];
+	if (held.chunk) {
+		lstate.rows_in_memory -= held.chunk->size();
+		held.chunk.reset();
+	} else {
+		held.run.reset();
+		held.head.reset();
+		held.run_chunk = 0;
+		held.run_offset = 0;
+		if (--lstate.spilled_chunks == 0) {
+			// Nothing spilled is held anymore: give the runs' blocks back
+			lstate.spill_allocator.reset();
+		}
+	}
+	lstate.free_slots.push_back(slot);
+}
+
+// Computes the release time of every row of the chunk and holds the chunk until all of them are released
+static void AbsorbChunk(ClientContext &context, const DelayRowsBindData &bind_data, DataChunk &input,
+                        DelayRowsLocalState &lstate) {
+	auto count = input.size();
+	auto &source = input.data[bind_data.delay_column];
+	auto interval = source.GetType().id() == LogicalTypeId::INTERVAL;
+	Vector delays(interval ? LogicalType::INTERVAL : LogicalType::DOUBLE, count);
+	if (source.GetType() == delays.GetType()) {
+		delays.Reference(source);
+	} else {
+		VectorOperations::Cast(context, source, delays, count);
+	}
+	UnifiedVectorFormat format;
+	delays.ToUnifiedFormat(count, format);
+
+	// Release times are measured from the moment the chunk arrives
+	auto arrival_ns = SleepClockNow(context, lstate.clock);
+	vector<int64_t> deadlines(count);
+	for (idx_t row = 0; row < count; row++) {
+		auto idx = format.sel->get_index(row);
+		int64_t micros = 0;
+		if (format.validity.RowIsValid(idx)) {
+			if (interval) {
+				micros = IntervalToSleepMicros(UnifiedVectorFormat::GetData<interval_t>(format)[idx]);
+			} else {
+				micros = SecondsToSleepMicros(UnifiedVectorFormat::GetData<double>(format)[idx]);
+			}
+		}
+		deadlines[row] = arrival_ns + ScaleSleepMicros(micros, lstate.time_scale) * NANOS_PER_MICRO;
+	}
+
+	uint32_t slot;
+	if (lstate.free_slots.empty()) {
+		slot = static_cast<uint32_t>(lstate.slots.size());
+		lstate.slots.emplace_back();
+	} else {
+		slot = lstate.free_slots.back();
+		lstate.free_slots.pop_back();
+	}
+	auto &held = lstate.slots[slot];
+	held.remaining = count;
+	auto sequence = lstate.next_sequence;
+	lstate.next_sequence += count;
+	if (lstate.rows_in_memory + count > lstate.spill_threshold) {
+		SpillChunk(context, lstate, input, deadlines, sequence, held);
+		// The run's rows are sorted, so its earliest row stands in for all of them; the stable sort puts the first
+		// arrival among the rows with that deadline in front
+		auto first = std::min_element(deadlines.begin(), deadlines.end());
+		auto first_sequence = sequence + static_cast<uint64_t>(first - deadlines.begin());
+		lstate.heap.push_back(DelayHeapEntry {*first, first_sequence, slot, 0});
+		std::push_heap(lstate.heap.begin(), lstate.heap.end(), DelayReleasesLater);
+		return;
+	}
+	held.chunk = make_uniq<DataChunk>();
+	held.chunk->Initialize(Allocator::Get(context), input.GetTypes());
+	input.Copy(*held.chunk);
+	lstate.rows_in_memory += count;
+	for (idx_t row = 0; row < count; row++) {
+		lstate.heap.push_back(DelayHeapEntry {deadlines[row], sequence + row, slot, static_cast<sel_t>(row)});
+		std::push_heap(lstate.heap.begin(), lstate.heap.end(), DelayReleasesLater);
+	}
+}
+
+// Copies the due rows collected from one source to the output
+static void CopyDueRows(DelayRowsLocalState &lstate, DataChunk &output) {
+	if (lstate.due_count == 0) {
+		return;
+	}
+	auto out_idx = output.size();
+	for (idx_t col_idx = 0; col_idx < output.ColumnCount(); col_idx++) {
+		VectorOperations::Copy(lstate.due_source->data[col_idx], output.data[col_idx], lstate.sel, lstate.due_count, 0,
+		                       out_idx);
+	}
+	output.SetCardinality(out_idx + lstate.due_count);
+	lstate.due_count = 0;
+}
+
+// Releases the rows whose deadline lies at or before now into the output, earliest first
+// Consecutive rows from the same held chunk or buffered run head are copied together
+static void ReleaseDueRows(ClientContext &context, DelayRowsLocalState &lstate, int64_t now, DataChunk &output) {
+	output.SetCardinality(0);
+	lstate.due_source = nullptr;
+	lstate.due_count = 0;
+	while (!lstate.heap.empty() && output.size() + lstate.due_count < STANDARD_VECTOR_SIZE &&
+	       lstate.heap.front().deadline_ns <= now) {
+		std::pop_heap(lstate.heap.begin(), lstate.heap.end(), DelayReleasesLater);
+		auto entry = lstate.heap.back();
+		lstate.heap.pop_back();
+		auto &held = lstate.slots[entry.slot];
+		if (!held.chunk && (!held.head || held.cursor == held.head->size())) {
+			// The rows collected from the head are copied out before it is refilled
+			CopyDueRows(lstate, output);
+			LoadRunHead(context, lstate, held);
+		}
+		auto &source = held.chunk ? *held.chunk : *held.head;
+		if (&source != lstate.due_source) {
+			CopyDueRows(lstate, output);
+			lstate.due_source = &source;
+		}
+		lstate.sel.set_index(lstate.due_count++, held.chunk ? entry.row : static_cast<sel_t>(held.cursor++));
+		held.remaining--;
+		if (held.remaining == 0) {
+			CopyDueRows(lstate, output);
+			lstate.due_source = nullptr;
+			ReleaseSlot(lstate, entry.slot);
+			continue;
+		}
+		if (!held.chunk) {
+			// The next row of the run takes the place of the one that was just released
+			if (held.cursor == held.head->size()) {
+				CopyDueRows(lstate, output);
+				LoadRunHead(context, lstate, held);
+			}
+			auto &head = *held.head;
+			auto deadline_column = head.ColumnCount() - 2;
+			auto deadline = FlatVector::GetData<int64_t>(head.data[deadline_column])[held.cursor];
+			auto sequence = FlatVector::GetData<uint64_t>(head.data[deadline_column + 1])[held.cursor];
+			lstate.heap.push_back(DelayHeapEntry {deadline, sequence, entry.slot, 0});
+			std::push_heap(lstate.heap.begin(), lstate.heap.end(), DelayReleasesLater);
+		}
+	}
+	CopyDueRows(lstate, output);
+}
+
+// Holds every input row until its delay has passed, measured from its arrival, and releases rows by deadline
+// Input keeps being consumed while held rows wait, so rows leave out of arrival order when their delays differ
+static OperatorResultType DelayRowsFunction(ExecutionContext &context, TableFunctionInput &data_p, DataChunk &input,
+                                            DataChunk &output) {
+	auto &bind_data = data_p.bind_data->Cast<DelayRowsBindData>();
+	auto &lstate = data_p.local_state->Cast<DelayRowsLocalState>();
+	CheckInterruption(context.client);
+	if (!lstate.absorbed && input.size() > 0) {
+		AbsorbChunk(context.client, bind_data, input, lstate);
+		lstate.absorbed = true;
+	}
+	ReleaseDueRows(context.client, lstate, SleepClockNow(context.client, lstate.clock), output);
+	if (output.size() == STANDARD_VECTOR_SIZE) {
+		// More rows may be due: come back before consuming the next chunk
+		return OperatorResultType::HAVE_MORE_OUTPUT;
+	}
+	lstate.absorbed = false;
+	return OperatorResultType::NEED_MORE_INPUT;
+}
+
+// Once the input is exhausted, waits for the remaining rows one deadline at a time
+static OperatorFinalizeResultType DelayRowsFinal(ExecutionContext &context, TableFunctionInput &data_p,
+                                                 DataChunk &output) {
+	auto &lstate = data_p.local_state->Cast<DelayRowsLocalState>();
+	if (lstate.heap.empty()) {
+		return OperatorFinalizeResultType::FINISHED;
+	}
+	auto deadline = lstate.heap.front().deadline_ns;
+	PerformSleepUntil(context.client, lstate.clock, deadline);
+	auto now = MaxValue<int64_t>(SleepClockNow(context.client, lstate.clock), deadline);
+	ReleaseDueRows(context.client, lstate, now, output);
+	return OperatorFinalizeResultType::HAVE_MORE_OUTPUT;
+}
+
+//===--------------------------------------------------------------------===//
+// Registration
+//===--------------------------------------------------------------------===//
+
+void RegisterReplayFunctions(ExtensionLoader &loader) {
+	// Register replay(table, ts_column, speed := 1.0)
+	TableFunction replay("replay", {LogicalType::TABLE, LogicalType::VARCHAR}, nullptr, ReplayBind, ReplayInitGlobal,
+	                     ReplayInitLocal);
+	replay.in_out_function = ReplayFunction;
+	replay.named_parameters["speed"] = LogicalType::DOUBLE;
+	loader.RegisterFunction(replay);
+
+	// Feed every replay from a single thread, in the order of its input
+	OptimizerExtension optimizer;
+	optimizer.optimize_function = ReplayOptimize;
+	DBConfig::GetConfig(loader.GetDatabaseInstance()).optimizer_extensions.push_back(std::move(optimizer));
+
+	// Register delay_rows(table, delay_column)
+	TableFunction delay_rows("delay_rows", {LogicalType::TABLE, LogicalType::VARCHAR}, nullptr, DelayRowsBind, nullptr,
+	                         DelayRowsInitLocal);
+	delay_rows.in_out_function = DelayRowsFunction;
+	delay_rows.in_out_function_final = DelayRowsFinal;
+	loader.RegisterFunction(delay_rows);
+}
+
+} // namespace duckdb
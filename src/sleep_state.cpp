@@ -0,0 +1,81 @@
+#include "sleep_state.hpp"
+#include "sleep_engine.hpp"
+
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+SleepDatabaseState::SleepDatabaseState(int64_t start_ns) : virtual_clock(start_ns) {
+}
+
+namespace {
+
+struct SleepStateEntry {
+	//! Detects a database that was closed and another one allocated at the same address
+	weak_ptr<DatabaseInstance> db;
+	shared_ptr<SleepDatabaseState> state;
+};
+
+struct SleepStateRegistry {
+	std::mutex lock;
+	std::unordered_map<DatabaseInstance *, SleepStateEntry> entries;
+};
+
+} // namespace
+
+static SleepStateRegistry &GetRegistry() {
+	static SleepStateRegistry registry;
+	return registry;
+}
+
+static shared_ptr<SleepDatabaseState> GetSharedState(DatabaseInstance &db) {
+	auto &registry = GetRegistry();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	auto entry = registry.entries.find(&db);
+	if (entry != registry.entries.end() && !entry->second.db.expired()) {
+		return entry->second.state;
+	}
+	// Drop the state of databases that have been closed since the last registration
+	for (auto it = registry.entries.begin(); it != registry.entries.end();) {
+		if (it->second.db.expired()) {
+			it = registry.entries.erase(it);
+		} else {
+			it++;
+		}
+	}
+	auto start_ns = Timestamp::GetCurrentTimestamp().value * NANOS_PER_MICRO;
+	auto &result = registry.entries[&db];
+	result.db = db.shared_from_this();
+	result.state = make_shared_ptr<SleepDatabaseState>(start_ns);
+	return result.state;
+}
+
+// The state of the connection's database, kept by the connection; the connection keeps its database open, so the
+// cached state stays the one the registry holds for it
+class SleepDatabaseStateCache : public ClientContextState {
+public:
+	explicit SleepDatabaseStateCache(shared_ptr<SleepDatabaseState> state) : state(std::move(state)) {
+	}
+
+	shared_ptr<SleepDatabaseState> state;
+};
+
+SleepDatabaseState &SleepDatabaseState::Get(ClientContext &context) {
+	auto cache = context.registered_state->Get<SleepDatabaseStateCache>("sleep_database_state");
+	if (!cache) {
+		cache = context.registered_state->GetOrCreate<SleepDatabaseStateCache>("sleep_database_state",
+		                                                                      GetSharedState(*context.db));
+	}
+	return *cache->state;
+}
+
+SleepDatabaseState &SleepDatabaseState::Get(DatabaseInstance &db) {
+	return *GetSharedState(db);
+}
+
+} // namespace duckdb
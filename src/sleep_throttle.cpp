@@ -0,0 +1,436 @@
+#include "sleep_throttle.hpp"
+#include "sleep_state.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension/extension_loader.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <cmath>
+
+namespace duckdb {
+
+//===--------------------------------------------------------------------===//
+// Token Bucket
+//===--------------------------------------------------------------------===//
+
+// A single reservation never costs more than the longest sleep, so huge chunks at tiny rates cannot overflow the TAT
+static constexpr int64_t MAX_RESERVATION_NS = MAX_SLEEP_MICROS * NANOS_PER_MICRO;
+
+SleepTokenBucket::SleepTokenBucket(SleepClock clock, double tokens_per_second, double burst, double time_scale)
+    : clock(clock), arrival_ns(0), tokens(0), token_ns(0), tolerance_ns(0), configured_rate(0), configured_burst(0),
+      configured_time_scale(0) {
+	Configure(tokens_per_second, burst, time_scale);
+}
+
+void SleepTokenBucket::Configure(double tokens_per_second, double burst, double time_scale) {
+	// Shared buckets are configured on every lookup, which then only costs the comparison
+	if (tokens_per_second == configured_rate && burst == configured_burst && time_scale == configured_time_scale) {
+		return;
+	}
+	configured_rate = tokens_per_second;
+	configured_burst = burst;
+	configured_time_scale = time_scale;
+	auto cost = static_cast<double>(NANOS_PER_SECOND) / tokens_per_second * time_scale;
+	token_ns.store(cost, std::memory_order_relaxed);
+	auto tolerance = MinValue<double>(burst * cost, static_cast<double>(MAX_RESERVATION_NS));
+	tolerance_ns.store(static_cast<int64_t>(tolerance), std::memory_order_relaxed);
+}
+
+SleepTokenBucket::Reservation SleepTokenBucket::Reserve(int64_t now_ns, idx_t count) {
+	auto cost = static_cast<double>(count) * token_ns.load(std::memory_order_relaxed);
+	auto cost_ns = MinValue<double>(cost, static_cast<double>(MAX_RESERVATION_NS));
+	auto reservation_ns = static_cast<int64_t>(std::llround(cost_ns));
+	// An idle bucket restarts from the present, so unused time never accumulates beyond the burst tolerance
+	auto current = arrival_ns.load(std::memory_order_acquire);
+	int64_t next;
+	do {
+		next = MaxValue<int64_t>(current, now_ns) + reservation_ns;
+	} while (!arrival_ns.compare_exchange_weak(current, next, std::memory_order_acq_rel));
+
+	Reservation result;
+	result.ready_ns = next - tolerance_ns.load(std::memory_order_relaxed);
+	result.first_token = tokens.fetch_add(count, std::memory_order_relaxed);
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Statistics
+//===--------------------------------------------------------------------===//
+
+struct SleepThrottleCounters {
+	std::atomic<uint64_t> tokens {0};
+	std::atomic<uint64_t> waits {0};
+	std::atomic<uint64_t> wait_total_us {0};
+	std::atomic<uint64_t> buckets_expired {0};
+};
+
+static SleepThrottleCounters &GetCounters() {
+	static SleepThrottleCounters counters;
+	return counters;
+}
+
+//===--------------------------------------------------------------------===//
+// Bucket Map
+//===--------------------------------------------------------------------===//
+
+shared_ptr<SleepTokenBucket> SleepBucketMap::Get(ClientContext &context, string_t key, SleepClock clock,
+                                                 double tokens_per_second, double burst, double time_scale) {
+	// The shard takes the top bits of the hash, the map inside the shard the rest
+	auto hash = StringHash()(key);
+	auto &shard = shards[(hash >> 32) % SHARD_COUNT];
+	std::lock_guard<std::mutex> guard(shard.lock);
+	if (++shard.lookups % SWEEP_INTERVAL == 0) {
+		Sweep(context, shard);
+	}
+	auto entry = shard.buckets.find(key);
+	if (entry == shard.buckets.end()) {
+		auto new_entry = make_uniq<Entry>();
+		new_entry->key = key.GetString();
+		// The map's key points into the entry's own copy, which keeps its address while the entry exists
+		string_t owned_key(new_entry->key.c_str(), UnsafeNumericCast<uint32_t>(new_entry->key.size()));
+		entry = shard.buckets.emplace(owned_key, std::move(new_entry)).first;
+	}
+	auto &bucket = entry->second->bucket;
+	if (bucket && bucket->clock == clock) {
+		bucket->Configure(tokens_per_second, burst, time_scale);
+	} else {
+		bucket = make_shared_ptr<SleepTokenBucket>(clock, tokens_per_second, burst, time_scale);
+	}
+	return bucket;
+}
+
+void SleepBucketMap::Sweep(ClientContext &context, Shard &shard) {
+	// Each clock is read at most once per sweep: reading the virtual clock takes the lock of the database registry
+	static constexpr idx_t CLOCK_COUNT = static_cast<idx_t>(SleepClock::VIRTUAL) + 1;
+	int64_t now_ns[CLOCK_COUNT];
+	bool now_read[CLOCK_COUNT] = {};
+	// Buckets still referenced by a running query are kept even when idle
+	for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+		auto &bucket = it->second->bucket;
+		if (bucket.use_count() != 1) {
+			it++;
+			continue;
+		}
+		auto clock = static_cast<idx_t>(bucket->clock);
+		if (!now_read[clock]) {
+			now_ns[clock] = bucket->Now(context);
+			now_read[clock] = true;
+		}
+		if (bucket->IsIdle(now_ns[clock], IDLE_EXPIRY_NS)) {
+			it = shard.buckets.erase(it);
+			GetCounters().buckets_expired.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			it++;
+		}
+	}
+}
+
+idx_t SleepBucketMap::Size() {
+	idx_t result = 0;
+	for (auto &shard : shards) {
+		std::lock_guard<std::mutex> guard(shard.lock);
+		result += shard.buckets.size();
+	}
+	return result;
+}
+
+SleepThrottleStatistics GetSleepThrottleStatistics() {
+	auto &counters = GetCounters();
+	SleepThrottleStatistics result;
+	result.tokens = counters.tokens.load();
+	result.waits = counters.waits.load();
+	result.wait_total_us = counters.wait_total_us.load();
+	result.buckets_expired = counters.buckets_expired.load();
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Acquire
+//===--------------------------------------------------------------------===//
+
+double ValidateThrottleRate(const string &function_name, double tokens_per_second) {
+	if (!std::isfinite(tokens_per_second) || tokens_per_second <= 0) {
+		throw InvalidInputException("%s: the rate must be a positive, finite number", function_name);
+	}
+	return tokens_per_second;
+}
+
+uint64_t ThrottleAcquire(ClientContext &context, SleepTokenBucket &bucket, idx_t count) {
+	CheckInterruption(context);
+	auto now_ns = bucket.Now(context);
+	auto reservation = bucket.Reserve(now_ns, count);
+	auto &counters = GetCounters();
+	counters.tokens.fetch_add(count, std::memory_order_relaxed);
+	if (reservation.ready_ns > now_ns) {
+		counters.waits.fetch_add(1, std::memory_order_relaxed);
+		counters.wait_total_us.fetch_add(static_cast<uint64_t>((reservation.ready_ns - now_ns) / NANOS_PER_MICRO),
+		                                 std::memory_order_relaxed);
+		PerformSleepUntil(context, bucket.clock, reservation.ready_ns);
+	}
+	return reservation.first_token;
+}
+
+//===--------------------------------------------------------------------===//
+// throttle
+//===--------------------------------------------------------------------===//
+
+struct ThrottleBindData : public FunctionData {
+	explicit ThrottleBindData(shared_ptr<SleepTokenBucket> bucket) : bucket(std::move(bucket)) {
+	}
+
+	//! Shared by every thread of the query, or by every query using the same key
+	shared_ptr<SleepTokenBucket> bucket;
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<ThrottleBindData>(bucket);
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		return bucket == other_p.Cast<ThrottleBindData>().bucket;
+	}
+};
+
+static Value EvaluateConstantArgument(ClientContext &context, const string &function_name, Expression &argument) {
+	if (!argument.IsFoldable()) {
+		throw BinderException("%s: all arguments must be constants", function_name);
+	}
+	return ExpressionExecutor::EvaluateScalar(context, argument);
+}
+
+// Binds the constant rate at rate_idx and the optional key after it to a query-wide or keyed bucket
+static unique_ptr<FunctionData> BindThrottleBucket(ClientContext &context, const string &function_name,
+                                                   vector<unique_ptr<Expression>> &arguments, idx_t rate_idx) {
+	auto rate = EvaluateConstantArgument(context, function_name, *arguments[rate_idx]);
+	if (rate.IsNull()) {
+		throw InvalidInputException("%s: the rate must not be NULL", function_name);
+	}
+	auto tokens_per_second = ValidateThrottleRate(function_name, rate.GetValue<double>());
+	auto clock = GetSleepClock(context);
+	auto time_scale = GetSleepTimeScale(context);
+	if (arguments.size() > rate_idx + 1) {
+		auto key = EvaluateConstantArgument(context, function_name, *arguments[rate_idx + 1]);
+		if (!key.IsNull()) {
+			auto &state = SleepDatabaseState::Get(context);
+			auto key_string = key.ToString();
+			string_t key_ref(key_string.c_str(), UnsafeNumericCast<uint32_t>(key_string.size()));
+			return make_uniq<ThrottleBindData>(
+			    state.throttle_buckets.Get(context, key_ref, clock, tokens_per_second, 0, time_scale));
+		}
+	}
+	return make_uniq<ThrottleBindData>(make_shared_ptr<SleepTokenBucket>(clock, tokens_per_second, 0, time_scale));
+}
+
+static unique_ptr<FunctionData> ThrottleBind(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+	return BindThrottleBucket(context, "throttle", arguments, 0);
+}
+
+// throttle(rows_per_second [, key])
+// Paces the rows passing through so that all threads of the query, or all queries using the same key, together stay
+// at or below the rate; returns the running number of rows admitted by the bucket
+static void ThrottleFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto &bind_data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<ThrottleBindData>();
+	auto count = args.size();
+	auto first_token = ThrottleAcquire(context, *bind_data.bucket, count);
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_data = FlatVector::GetData<int64_t>(result);
+	for (idx_t i = 0; i < count; i++) {
+		result_data[i] = static_cast<int64_t>(first_token + i + 1);
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// throttle_bytes
+//===--------------------------------------------------------------------===//
+
+// Total size in bytes of the non-NULL strings or blobs of a chunk
+// Flat vectors without NULLs take a contiguous loop the compiler can vectorize
+static idx_t PayloadBytes(Vector &payload, idx_t count) {
+	if (payload.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+		return ConstantVector::IsNull(payload) ? 0 : ConstantVector::GetData<string_t>(payload)->GetSize() * count;
+	}
+	UnifiedVectorFormat vdata;
+	payload.ToUnifiedFormat(count, vdata);
+	auto data = UnifiedVectorFormat::GetData<string_t>(vdata);
+	idx_t bytes = 0;
+	if (!vdata.sel->IsSet() && vdata.validity.AllValid()) {
+		for (idx_t i = 0; i < count; i++) {
+			bytes += data[i].GetSize();
+		}
+	} else {
+		for (idx_t i = 0; i < count; i++) {
+			auto idx = vdata.sel->get_index(i);
+			bytes += vdata.validity.RowIsValid(idx) ? data[idx].GetSize() : 0;
+		}
+	}
+	return bytes;
+}
+
+static unique_ptr<FunctionData> ThrottleBytesBind(ClientContext &context, ScalarFunction &bound_function,
+                                                  vector<unique_ptr<Expression>> &arguments) {
+	return BindThrottleBucket(context, "throttle_bytes", arguments, 1);
+}
+
+// throttle_bytes(payload, bytes_per_second [, key])
+// Paces a stream of strings or blobs by their size, then returns the payload by reference
+static void ThrottleBytesFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &bind_data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<ThrottleBindData>();
+	auto &payload = args.data[0];
+	auto bytes = PayloadBytes(payload, args.size());
+	if (bytes > 0) {
+		ThrottleAcquire(state.GetContext(), *bind_data.bucket, bytes);
+	}
+	result.Reference(payload);
+}
+
+//===--------------------------------------------------------------------===//
+// throttle_key
+//===--------------------------------------------------------------------===//
+
+// Rows of one chunk that share a key
+struct ThrottleKeyGroup {
+	string_t key;
+	double rate;
+	double burst;
+	idx_t count;
+	uint64_t next_token;
+};
+
+static void ValidateBurst(double burst) {
+	if (!std::isfinite(burst) || burst < 0) {
+		throw InvalidInputException("throttle_key: the burst must be a non-negative, finite number");
+	}
+}
+
+// throttle_key(key, rows_per_second, burst)
+// Rate-limits the rows of every key independently, e.g. per tenant; each key's bucket admits up to burst rows at once
+// and is shared by all queries. Returns the running number of rows admitted for the row's key, NULL rows pass freely
+static void ThrottleKeyFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto count = args.size();
+	UnifiedVectorFormat key_data;
+	UnifiedVectorFormat rate_data;
+	UnifiedVectorFormat burst_data;
+	args.data[0].ToUnifiedFormat(count, key_data);
+	args.data[1].ToUnifiedFormat(count, rate_data);
+	args.data[2].ToUnifiedFormat(count, burst_data);
+	auto keys = UnifiedVectorFormat::GetData<string_t>(key_data);
+	auto rates = UnifiedVectorFormat::GetData<double>(rate_data);
+	auto bursts = UnifiedVectorFormat::GetData<double>(burst_data);
+
+	// Group the rows by key first, so each distinct key costs one bucket lookup and one reservation per chunk
+	// instead of one per row; the first row of a key decides its rate and burst
+	string_map_t<idx_t> group_index;
+	vector<ThrottleKeyGroup> groups;
+	idx_t row_groups[STANDARD_VECTOR_SIZE];
+	for (idx_t i = 0; i < count; i++) {
+		auto key_idx = key_data.sel->get_index(i);
+		auto rate_idx = rate_data.sel->get_index(i);
+		auto burst_idx = burst_data.sel->get_index(i);
+		if (!key_data.validity.RowIsValid(key_idx) || !rate_data.validity.RowIsValid(rate_idx) ||
+		    !burst_data.validity.RowIsValid(burst_idx)) {
+			row_groups[i] = DConstants::INVALID_INDEX;
+			continue;
+		}
+		auto entry = group_index.find(keys[key_idx]);
+		if (entry != group_index.end()) {
+			row_groups[i] = entry->second;
+			groups[entry->second].count++;
+			continue;
+		}
+		ThrottleKeyGroup group;
+		group.key = keys[key_idx];
+		group.rate = ValidateThrottleRate("throttle_key", rates[rate_idx]);
+		group.burst = bursts[burst_idx];
+		ValidateBurst(group.burst);
+		group.count = 1;
+		group.next_token = 0;
+		row_groups[i] = groups.size();
+		group_index[group.key] = groups.size();
+		groups.push_back(group);
+	}
+
+	// Reserve for every key, then wait once for the key whose tokens become available last
+	if (!groups.empty()) {
+		auto clock = GetSleepClock(context);
+		auto time_scale = GetSleepTimeScale(context);
+		auto &bucket_map = SleepDatabaseState::Get(context).throttle_buckets;
+		auto now_ns = SleepClockNow(context, clock);
+		auto ready_ns = now_ns;
+		idx_t admitted = 0;
+		for (auto &group : groups) {
+			auto bucket = bucket_map.Get(context, group.key, clock, group.rate, group.burst, time_scale);
+			auto reservation = bucket->Reserve(now_ns, group.count);
+			group.next_token = reservation.first_token;
+			ready_ns = MaxValue<int64_t>(ready_ns, reservation.ready_ns);
+			admitted += group.count;
+		}
+		auto &counters = GetCounters();
+		counters.tokens.fetch_add(admitted, std::memory_order_relaxed);
+		if (ready_ns > now_ns) {
+			counters.waits.fetch_add(1, std::memory_order_relaxed);
+			counters.wait_total_us.fetch_add(static_cast<uint64_t>((ready_ns - now_ns) / NANOS_PER_MICRO),
+			                                 std::memory_order_relaxed);
+			PerformSleepUntil(context, clock, ready_ns);
+		}
+	}
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	auto result_data = FlatVector::GetData<int64_t>(result);
+	auto &result_validity = FlatVector::Validity(result);
+	for (idx_t i = 0; i < count; i++) {
+		if (row_groups[i] == DConstants::INVALID_INDEX) {
+			result_validity.SetInvalid(i);
+			continue;
+		}
+		result_data[i] = static_cast<int64_t>(++groups[row_groups[i]].next_token);
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// Registration
+//===--------------------------------------------------------------------===//
+
+void RegisterThrottleFunctions(ExtensionLoader &loader) {
+	// Register throttle(rows_per_second [, key])
+	ScalarFunctionSet throttle("throttle");
+	ScalarFunction throttle_unkeyed({LogicalType::DOUBLE}, LogicalType::BIGINT, ThrottleFunction, ThrottleBind);
+	throttle_unkeyed.stability = FunctionStability::VOLATILE;
+	throttle_unkeyed.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+	throttle.AddFunction(throttle_unkeyed);
+	ScalarFunction throttle_keyed({LogicalType::DOUBLE, LogicalType::VARCHAR}, LogicalType::BIGINT, ThrottleFunction,
+	                              ThrottleBind);
+	throttle_keyed.stability = FunctionStability::VOLATILE;
+	throttle_keyed.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+	throttle.AddFunction(throttle_keyed);
+	loader.RegisterFunction(throttle);
+
+	// Register throttle_bytes(payload, bytes_per_second [, key]) for strings and blobs
+	// NULL payloads pass through as NULL, a NULL rate is rejected by the bind
+	ScalarFunctionSet throttle_bytes("throttle_bytes");
+	for (auto &payload_type : {LogicalType::VARCHAR, LogicalType::BLOB}) {
+		ScalarFunction unkeyed({payload_type, LogicalType::DOUBLE}, payload_type, ThrottleBytesFunction,
+		                       ThrottleBytesBind);
+		unkeyed.stability = FunctionStability::VOLATILE;
+		unkeyed.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+		throttle_bytes.AddFunction(unkeyed);
+		ScalarFunction keyed({payload_type, LogicalType::DOUBLE, LogicalType::VARCHAR}, payload_type,
+		                     ThrottleBytesFunction, ThrottleBytesBind);
+		keyed.stability = FunctionStability::VOLATILE;
+		keyed.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+		throttle_bytes.AddFunction(keyed);
+	}
+	loader.RegisterFunction(throttle_bytes);
+
+	// Register throttle_key(key, rows_per_second, burst)
+	ScalarFunction throttle_key("throttle_key", {LogicalType::VARCHAR, LogicalType::DOUBLE, LogicalType::DOUBLE},
+	                            LogicalType::BIGINT, ThrottleKeyFunction);
+	throttle_key.stability = FunctionStability::VOLATILE;
+	loader.RegisterFunction(throttle_key);
+}
+
+} // namespace duckdb
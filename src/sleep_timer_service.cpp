@@ -0,0 +1,293 @@
+#include "sleep_timer_service.hpp"
+
+#include "duckdb/common/bit_utils.hpp"
+#include "duckdb/common/limits.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+static constexpr uint64_t NO_TICK = NumericLimits<uint64_t>::Maximum();
+
+SleepTimerService::SleepTimerService() : epoch(std::chrono::steady_clock::now()) {
+}
+
+SleepTimerService::~SleepTimerService() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		shutdown = true;
+	}
+	cv.notify_one();
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+SleepTimerService &SleepTimerService::Get() {
+	static SleepTimerService service;
+	return service;
+}
+
+void SleepTimerService::Start() {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!thread.joinable()) {
+		thread = std::thread([this]() { Run(); });
+	}
+}
+
+uint64_t SleepTimerService::TickAt(time_point_t time) const {
+	if (time <= epoch) {
+		return 0;
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - epoch).count();
+	return static_cast<uint64_t>(elapsed / TICK_MICROS);
+}
+
+SleepTimerService::time_point_t SleepTimerService::TimeOfTick(uint64_t tick) const {
+	return epoch + std::chrono::microseconds(static_cast<int64_t>(tick) * TICK_MICROS);
+}
+
+//===--------------------------------------------------------------------===//
+// Wheel Maintenance (lock held)
+//===--------------------------------------------------------------------===//
+
+void SleepTimerService::Insert(SleepTimer &timer) {
+	D_ASSERT(timer.expiry_tick >= current_tick);
+	auto delta = timer.expiry_tick - current_tick;
+	idx_t level = 0;
+	while (level + 1 < LEVEL_COUNT && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+		level++;
+	}
+	auto index = (timer.expiry_tick >> (SLOT_BITS * level)) & SLOT_MASK;
+	auto &head = wheel[level][index];
+	occupied[level] |= uint64_t(1) << index;
+	timer.prev = nullptr;
+	timer.next = head;
+	if (head) {
+		head->prev = &timer;
+	}
+	head = &timer;
+	timer.slot = &head;
+}
+
+void SleepTimerService::Unlink(SleepTimer &timer) {
+	D_ASSERT(timer.slot);
+	if (timer.prev) {
+		timer.prev->next = timer.next;
+	} else {
+		*timer.slot = timer.next;
+		if (!timer.next) {
+			auto offset = static_cast<idx_t>(timer.slot - &wheel[0][0]);
+			occupied[offset / SLOTS_PER_LEVEL] &= ~(uint64_t(1) << (offset % SLOTS_PER_LEVEL));
+		}
+	}
+	if (timer.next) {
+		timer.next->prev = timer.prev;
+	}
+	timer.prev = nullptr;
+	timer.next = nullptr;
+	timer.slot = nullptr;
+}
+
+void SleepTimerService::Disarm(SleepTimer &timer) {
+	Unlink(timer);
+	stats.armed--;
+	if (timer.context) {
+		if (timer.watch_prev) {
+			timer.watch_prev->watch_next = timer.watch_next;
+		} else {
+			watched = timer.watch_next;
+		}
+		if (timer.watch_next) {
+			timer.watch_next->watch_prev = timer.watch_prev;
+		}
+		timer.watch_prev = nullptr;
+		timer.watch_next = nullptr;
+	}
+}
+
+void SleepTimerService::Cascade(idx_t level) {
+	// Redistribute the slot that just came into range over the lower levels
+	auto index = (current_tick >> (SLOT_BITS * level)) & SLOT_MASK;
+	auto timer = wheel[level][index];
+	wheel[level][index] = nullptr;
+	occupied[level] &= ~(uint64_t(1) << index);
+	while (timer) {
+		auto next = timer->next;
+		timer->slot = nullptr;
+		Insert(*timer);
+		stats.cascaded++;
+		timer = next;
+	}
+}
+
+void SleepTimerService::ExpireSlot(SleepTimer *&slot) {
+	while (slot) {
+		auto &timer = *slot;
+		Disarm(timer);
+		stats.expired++;
+		timer.Fire(SleepTimerFireReason::EXPIRED, pending_callbacks);
+	}
+}
+
+uint64_t SleepTimerService::NextEventTick() const {
+	auto result = NO_TICK;
+	for (idx_t level = 0; level < LEVEL_COUNT; level++) {
+		if (!occupied[level]) {
+			continue;
+		}
+		// Slots of a level are visited in index order, one per 64^level ticks: rotate the bitmap so that bit 0 is the
+		// slot visited next, the lowest set bit is then the number of visits until an occupied slot comes up
+		auto shift = SLOT_BITS * level;
+		auto block = current_tick >> shift;
+		auto first = (block + 1) & SLOT_MASK;
+		auto bits = occupied[level];
+		auto rotated = first == 0 ? bits : (bits >> first) | (bits << (SLOTS_PER_LEVEL - first));
+		auto visits = CountZeros<uint64_t>::Trailing(rotated) + 1;
+		result = MinValue<uint64_t>(result, (block + visits) << shift);
+	}
+	return result;
+}
+
+void SleepTimerService::Advance(uint64_t target_tick) {
+	while (current_tick < target_tick) {
+		// Ticks without an occupied slot to expire or cascade are skipped in one step
+		auto next_tick = MinValue<uint64_t>(NextEventTick(), target_tick);
+		stats.ticks += next_tick - current_tick;
+		current_tick = next_tick;
+		for (idx_t level = 1; level < LEVEL_COUNT; level++) {
+			if (((current_tick >> (SLOT_BITS * (level - 1))) & SLOT_MASK) != 0) {
+				break;
+			}
+			Cascade(level);
+		}
+		ExpireSlot(wheel[0][current_tick & SLOT_MASK]);
+	}
+}
+
+void SleepTimerService::PollInterrupts() {
+	auto timer = watched;
+	while (timer) {
+		auto next = timer->watch_next;
+		if (timer->context->interrupted) {
+			Disarm(*timer);
+			stats.interrupted++;
+			timer->Fire(SleepTimerFireReason::INTERRUPTED, pending_callbacks);
+		}
+		timer = next;
+	}
+}
+
+void SleepTimerService::RunCallbacks(std::unique_lock<std::mutex> &guard) {
+	if (pending_callbacks.empty()) {
+		return;
+	}
+	// Rescheduling a task takes the executor lock, while a task being destroyed under that lock cancels its timer
+	// through the service lock; calling back without holding the service lock keeps the two from deadlocking
+	vector<InterruptState> callbacks;
+	std::swap(callbacks, pending_callbacks);
+	guard.unlock();
+	for (auto &callback : callbacks) {
+		callback.Callback();
+	}
+	guard.lock();
+}
+
+//===--------------------------------------------------------------------===//
+// Public Interface
+//===--------------------------------------------------------------------===//
+
+void SleepTimerService::Arm(SleepTimer &timer, time_point_t deadline) {
+	bool wake_service;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		D_ASSERT(!timer.IsArmed());
+		auto now = std::chrono::steady_clock::now();
+		if (stats.armed == 0) {
+			// The wheel is empty, so it can jump straight to the present instead of replaying idle ticks
+			current_tick = MaxValue<uint64_t>(current_tick, TickAt(now));
+		}
+		// Round up to the tick boundary at or after the deadline, never firing in the tick that is being processed
+		auto expiry_tick = TickAt(deadline - std::chrono::nanoseconds(1)) + 1;
+		expiry_tick = MaxValue<uint64_t>(expiry_tick, current_tick + 1);
+		expiry_tick = MinValue<uint64_t>(expiry_tick, current_tick + MAX_TICK_DELTA);
+		timer.expiry_tick = expiry_tick;
+		Insert(timer);
+		stats.armed++;
+		stats.total_armed++;
+		// The service only needs to wake up early if this timer expires, or its context must be polled, before the
+		// service's next wakeup
+		auto wakeup = TimeOfTick(expiry_tick);
+		if (timer.context) {
+			if (!watched) {
+				next_interrupt_poll = now + std::chrono::microseconds(INTERRUPT_POLL_MICROS);
+			}
+			timer.watch_prev = nullptr;
+			timer.watch_next = watched;
+			if (watched) {
+				watched->watch_prev = &timer;
+			}
+			watched = &timer;
+			wakeup = MinValue(wakeup, next_interrupt_poll);
+		}
+		wake_service = wakeup < next_wakeup;
+		if (wake_service) {
+			next_wakeup = wakeup;
+		}
+	}
+	if (wake_service) {
+		cv.notify_one();
+	}
+}
+
+bool SleepTimerService::Cancel(SleepTimer &timer) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!timer.IsArmed()) {
+		return false;
+	}
+	Disarm(timer);
+	stats.cancelled++;
+	return true;
+}
+
+SleepTimerStatistics SleepTimerService::GetStatistics() {
+	std::lock_guard<std::mutex> guard(lock);
+	auto result = stats;
+	std::unordered_set<ClientContext *> contexts;
+	for (auto timer = watched; timer; timer = timer->watch_next) {
+		contexts.insert(timer->context.get());
+	}
+	result.watched_contexts = contexts.size();
+	return result;
+}
+
+void SleepTimerService::Run() {
+	std::unique_lock<std::mutex> guard(lock);
+	while (!shutdown) {
+		if (stats.armed == 0) {
+			// Nothing pending: park without any periodic wakeups until a timer is armed
+			next_wakeup = time_point_t::max();
+			cv.wait(guard, [this]() { return shutdown || stats.armed > 0; });
+			continue;
+		}
+		stats.wakeups++;
+		auto now = std::chrono::steady_clock::now();
+		Advance(TickAt(now));
+		if (watched && now >= next_interrupt_poll) {
+			PollInterrupts();
+			next_interrupt_poll = now + std::chrono::microseconds(INTERRUPT_POLL_MICROS);
+		}
+		RunCallbacks(guard);
+		if (shutdown || stats.armed == 0) {
+			continue;
+		}
+		// Sleep until the next occupied slot comes due or the interrupt flags are polled again, whichever is first
+		next_wakeup = TimeOfTick(NextEventTick());
+		if (watched) {
+			next_wakeup = MinValue(next_wakeup, next_interrupt_poll);
+		}
+		cv.wait_until(guard, next_wakeup);
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,166 @@
+// Measures how long an interrupted sleep keeps running after ClientContext::Interrupt() is called, next to the
+// polling loop sleeps used before, which checked the flag every 100 ms
+// ClientContext::Interrupt only raises a flag, which the timer service polls every INTERRUPT_POLL_MICROS, so a sleep
+// must return within a millisecond instead of half the old polling interval on average
+// Whole queries are checked as well, with a looser bound as they also go through DuckDB's own cancellation
+
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "sleep_engine.hpp"
+#include "sleep_extension.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace duckdb;
+
+static constexpr int RUNS = 20;
+//! Sub-millisecond on a quiet machine; the median leaves some slack for CI, the slowest run a little more
+static constexpr int64_t MAX_MEDIAN_SLEEP_LATENCY_MICROS = 1000;
+static constexpr int64_t MAX_SLEEP_LATENCY_MICROS = 5000;
+static constexpr int64_t MAX_QUERY_LATENCY_MICROS = 50000;
+//! Interval of the polling loop sleeps used before the timer service
+static constexpr int64_t POLLING_INTERVAL_MILLIS = 100;
+
+static int64_t MicrosSince(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+// Runs the sleep on a second thread and interrupts it at an arbitrary point after it started; returns the
+// microseconds between the interrupt and the sleep returning, or -1 if the sleep was not interrupted
+template <class SLEEP>
+static int64_t MeasureInterruptLatency(DuckDB &db, int run, SLEEP sleep) {
+	Connection con(db);
+	auto &context = *con.context;
+	std::chrono::steady_clock::time_point finished;
+	bool interrupted = false;
+	std::thread worker([&]() {
+		interrupted = sleep(context);
+		finished = std::chrono::steady_clock::now();
+	});
+	// Let the interrupt land at a different point of the poll interval every run
+	std::this_thread::sleep_for(std::chrono::milliseconds(20 + run * 7));
+	auto start = std::chrono::steady_clock::now();
+	con.Interrupt();
+	worker.join();
+	return interrupted ? MicrosSince(start, finished) : -1;
+}
+
+// A 60 second sleep on the timer service
+static bool ServiceSleep(ClientContext &context) {
+	try {
+		PerformSleep(context, 60 * Interval::MICROS_PER_SEC);
+	} catch (InterruptException &) {
+		return true;
+	}
+	return false;
+}
+
+// The loop sleeps used before the timer service: wake up every 100 ms to check the flag
+static bool PollingSleep(ClientContext &context) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+	while (std::chrono::steady_clock::now() < deadline) {
+		if (context.interrupted) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(POLLING_INTERVAL_MILLIS));
+	}
+	return false;
+}
+
+static int64_t Median(vector<int64_t> values) {
+	std::sort(values.begin(), values.end());
+	return values[values.size() / 2];
+}
+
+static int64_t ArmedTimers(Connection &con) {
+	auto result = con.Query("SELECT value FROM sleep_stats() WHERE component = 'timer' AND name = 'armed'");
+	if (result->HasError() || result->RowCount() != 1) {
+		return 0;
+	}
+	return result->GetValue(0, 0).GetValue<int64_t>();
+}
+
+// Runs the query on a second thread, interrupts it settle_millis after its first sleep was parked on the timer service
+// and returns the microseconds between the interrupt and the query returning, or -1 if the query was not interrupted
+static int64_t MeasureQueryInterruptLatency(DuckDB &db, const string &query, int64_t settle_millis) {
+	Connection con(db);
+	Connection observer(db);
+	std::chrono::steady_clock::time_point finished;
+	bool interrupted = false;
+	std::thread worker([&]() {
+		auto result = con.Query(query);
+		finished = std::chrono::steady_clock::now();
+		interrupted = result->HasError() && result->GetErrorType() == ExceptionType::INTERRUPT;
+	});
+	while (ArmedTimers(observer) == 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(settle_millis));
+	auto start = std::chrono::steady_clock::now();
+	con.Interrupt();
+	worker.join();
+	return interrupted ? MicrosSince(start, finished) : -1;
+}
+
+int main() {
+	DuckDB db(nullptr);
+	db.LoadStaticExtension<SleepExtension>();
+	bool success = true;
+
+	vector<int64_t> service_latencies;
+	vector<int64_t> polling_latencies;
+	for (int run = 0; run < RUNS; run++) {
+		service_latencies.push_back(MeasureInterruptLatency(db, run, ServiceSleep));
+		polling_latencies.push_back(MeasureInterruptLatency(db, run, PollingSleep));
+	}
+	auto service_median = Median(service_latencies);
+	auto service_max = *std::max_element(service_latencies.begin(), service_latencies.end());
+	auto polling_median = Median(polling_latencies);
+	auto polling_max = *std::max_element(polling_latencies.begin(), polling_latencies.end());
+	printf("%-16s %12s %12s\n", "sleep", "median (us)", "max (us)");
+	printf("%-16s %12lld %12lld\n", "timer service", static_cast<long long>(service_median),
+	       static_cast<long long>(service_max));
+	printf("%-16s %12lld %12lld\n", "100 ms polling", static_cast<long long>(polling_median),
+	       static_cast<long long>(polling_max));
+	if (*std::min_element(service_latencies.begin(), service_latencies.end()) < 0) {
+		fprintf(stderr, "a sleep on the timer service was not interrupted\n");
+		success = false;
+	}
+	if (service_median > MAX_MEDIAN_SLEEP_LATENCY_MICROS || service_max > MAX_SLEEP_LATENCY_MICROS) {
+		fprintf(stderr, "expected interrupted sleeps to return within %lld us (median) and %lld us (all runs)\n",
+		        static_cast<long long>(MAX_MEDIAN_SLEEP_LATENCY_MICROS),
+		        static_cast<long long>(MAX_SLEEP_LATENCY_MICROS));
+		success = false;
+	}
+	if (service_median * 10 > polling_median) {
+		fprintf(stderr, "expected the timer service to cancel at least ten times faster than the polling loop\n");
+		success = false;
+	}
+
+	// The ticker is interrupted mid-stream, after several of its ticks have fired
+	struct InterruptedQuery {
+		const char *query;
+		int64_t settle_millis;
+	};
+	InterruptedQuery queries[] = {{"SELECT sleep(60)", 3},
+	                              {"SELECT count(*) FROM sleep_async(60)", 3},
+	                              {"SELECT sleep_until(now() + INTERVAL 60 SECOND)", 3},
+	                              {"SELECT count(*) FROM ticker(0.01, 1000000)", 55}};
+	for (auto &entry : queries) {
+		auto query = entry.query;
+		for (int run = 0; run < 5; run++) {
+			auto latency = MeasureQueryInterruptLatency(db, query, entry.settle_millis);
+			printf("%s: interrupted after %lld us\n", query, static_cast<long long>(latency));
+			if (latency < 0 || latency > MAX_QUERY_LATENCY_MICROS) {
+				fprintf(stderr, "%s: expected an interrupt within %lld us\n", query,
+				        static_cast<long long>(MAX_QUERY_LATENCY_MICROS));
+				success = false;
+			}
+		}
+	}
+	return success ? 0 : 1;
+}